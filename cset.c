@@ -20,6 +20,9 @@
 #include <assert.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
 
 
     /* * * * * Constant Definitions * * * * */
@@ -28,34 +31,301 @@
 #define DEFAULT_CAPACITY 32
 #define RESIZE_FACTOR 2
 
+//Searches over ranges at least this many bytes long (larger than a typical L1 cache) prefetch ahead.
+#define PREFETCH_MIN_BYTES (32 * 1024)
+
+//Maximum size of a keyed set's keys, in 64-bit words.
+#define MAX_KEY_WORDS 8
+
 //Maximum length of a toString representation of a set. Needs to be very high to accommodate printing power sets.
 #define SET_STR_MAX_LEN 2000
 
     /* * * * * Struct Definitions * * * * */
 
+/* Type Definition: SetExtras
+ * --------------------------
+ * The state of a set that most sets never need. A set without extras has the defaults: it uses default_allocator (or
+ * its slab owner's allocator) and default_policy, has one reference, is mutable and not interned, owns no slabs, and
+ * doesn't share its elements array.
+ *
+ * The growth policy decides how far the elements array grows when full and whether removals shrink it.
+ *
+ * All memory belonging to a set (its header, extras, elements array, slabs, and slab list) comes from its allocator,
+ * which sets derived from it share. slab_bytes is the total size of the set's slabs.
+ *
+ * An indirect set's record pool is allocated in chunks, which are kept in the set's slab list and freed with it, so
+ * moving slots moves pointers rather than records, and records never move. Freed records are chained through their
+ * first word into a free list, and new records come from the free list or else from the unused tail of the newest
+ * chunk (record_next, with records_left records remaining).
+ *
+ * A clone (see cset_clone) shares its original's elements array until one of them writes to it. While the array is
+ * shared, buffer_refs points to the number of sets sharing it, and each set takes a private copy before its first
+ * write to the array (see own_buffer). The last set holding the array frees it. The count is updated atomically, so
+ * that sets sharing an array can be used and deleted on different threads.
+ *
+ * refcount counts the references to the set (see cset_retain), and cset_delete only frees the set when the last one is
+ * released. Interned sets are immutable and point to the intern table they are canonical in, if it still exists.
+ */
+typedef struct {
+    const CSetAllocator* allocator;
+    CSetGrowthPolicy policy;
+    int refcount;
+    bool immutable;
+    bool slab_trivial;
+    CSetInternTable* intern_table;
+    void** slabs;
+    int n_slabs;
+    size_t slab_bytes;
+    void* free_records;
+    char* record_next;
+    size_t records_left;
+    int* buffer_refs;
+} SetExtras;
 
 /* Type Definition: CSet
  * ---------------------
- * The CSet is implemented as an ordered void* array.
+ * The CSet is implemented as an ordered void* array. The elements occupy a contiguous run of slots beginning at
+ * slot start, with free slots on either side, so that elements can be removed from or inserted near either end
+ * without shifting the whole array.
+ *
+ * Sets of sets built in bulk (such as power sets) may carve their element sets out of large slabs instead of
+ * allocating each one separately. The slabs are listed in the outer set and freed with it. A set living in a slab
+ * points to the set that owns the slab (slab_owner), and owns_elements is false until its elements array is moved out
+ * of the slab by a resize. The owner's slab_trivial flag is true as long as deleting it needs no work per element:
+ * every element is an unmodified slab set whose elements need no cleanup.
+ *
+ * Each element occupies a slot of slotsz bytes. Normally a slot is just the element, but in a keyed set each slot also
+ * holds the element's normalized key: key_words 64-bit words following the element (padded to a multiple of 8 bytes),
+ * most significant first. Keys are encoded by key_fn. A keyed set whose keys fully determine the order has no cmp_fn;
+ * if keys are only prefixes (as in string sets), elements with equal keys are compared with cmp_fn. Since the key
+ * travels with its element, everything that moves slots around works the same way for both kinds of set.
+ *
+ * A set is hashable if it has a hash_fn or if its keys fully determine its order. Its hash is the sum of the mixed
+ * hashes of its elements, which doesn't depend on their order. While hash_valid is true, hash is kept up to date as
+ * elements are inserted and removed; operations that move elements in bulk clear hash_valid instead, and cset_hash
+ * recomputes the sum when it is next needed.
+ *
+ * In an indirect set, the element part of each slot is a pointer to a record (the client's element) in a pool of
+ * fixed-size records owned by the set.
+ *
+ * Everything else a set may need (its slabs, record pool, allocator, references, and so on) lives in its extras,
+ * which are allocated the first time the set needs any of them (see SetExtras). Most sets never need them, and the
+ * subsets in a power set's slab normally don't, so their headers hold just the fields above.
  */ 
 struct CSetImplementation {
     void* elements;
+    size_t start;
+    size_t capacity;
     int n_elements;
+    uint8_t key_words;
+    bool owns_elements;
+    bool hash_valid;
+    bool indirect;
     size_t elemsz;
-    size_t capacity;
+    size_t slotsz;
+    KeyEncodeFn key_fn;
     CompareFn cmp_fn;
     CleanupElemFn cleanup_fn;
     ToStringFn toString_fn;
+    HashFn hash_fn;
+    uint64_t hash;
+    CSet* slab_owner;
+    SetExtras* extras;
+};
+
+/* Type Definition: InternEntry
+ * ----------------------------
+ * An entry of an intern table: a canonical set and its hash, cached so the table can be searched and resized without
+ * calling cset_hash. An entry whose set is NULL is empty.
+ */
+typedef struct {
+    uint64_t hash;
+    CSet* set;
+} InternEntry;
+
+/* Type Definition: CSetInternTable
+ * --------------------------------
+ * An intern table is an open-addressing hash table with linear probing. capacity is a power of two, and the table
+ * grows by the resizing factor before it becomes more than half full.
+ */
+struct CSetInternTableImplementation {
+    InternEntry* entries;
+    size_t capacity;
+    size_t n_sets;
+};
+
+/* Type Definition: SubsetIteratorKind
+ * -----------------------------------
+ * The kinds of subset enumeration a CSetSubsetIterator can perform.
+ */
+typedef enum { POWER_SET_ITERATOR, COMBINATIONS_ITERATOR } SubsetIteratorKind;
+
+/* Type Definition: CSetSubsetIterator
+ * -----------------------------------
+ * A subset iterator walks the subsets of a base set using a single reusable subset. started and finished record
+ * whether the first subset has been produced and whether the last one has.
+ *
+ * For power set iterators, the multiword integers chosen, position, and last (each words 64-bit words long, least
+ * significant word first) hold the bitmask of base indices currently in the subset, the Gray code position of the
+ * next subset to produce, and the position at which to stop. For combinations iterators, combo holds the k base
+ * indices of the current subset in increasing order, followed by a sentinel equal to the size of the base set.
+ */
+struct CSetSubsetIteratorImplementation {
+    SubsetIteratorKind kind;
+    CSet* base;
+    CSet* subset;
+    bool started;
+    bool finished;
+    int words;
+    uint64_t* chosen;
+    uint64_t* position;
+    uint64_t* last;
+    int k;
+    int* combo;
+};
+
+/* Type Definition: CSetFamily
+ * ---------------------------
+ * A family of subsets of a shared base set. Each subset is stored as a bitmask of words_per_mask 64-bit words, where
+ * bit i is set if the base set's ith element is in the subset. The masks are stored back to back in one array.
+ */
+struct CSetFamilyImplementation {
+    CSet* base;
+    int words_per_mask;
+    uint64_t* masks;
+    int n_subsets;
+    size_t capacity;
 };
 
     /* * * * * Private Helper Functions * * * * */
 
+/* Functions: default_alloc, default_realloc, default_free
+ * -------------------------------------------------------
+ * The callbacks of the default allocator, which wrap the C library's allocation functions.
+ */
+static void* default_alloc(void* ctx, size_t size) {
+    return malloc(size);
+}
+
+static void* default_realloc(void* ctx, void* addr, size_t old_size, size_t new_size) {
+    return realloc(addr, new_size);
+}
+
+static void default_free(void* ctx, void* addr) {
+    free(addr);
+}
+
+static const CSetAllocator default_allocator = {default_alloc, default_realloc, default_free, NULL};
+
+static const CSetGrowthPolicy default_policy = {RESIZE_FACTOR, 0, 0};
+
+/* Function: allocator_of
+ * ----------------------
+ * Returns the set's allocator. A set in a slab uses the allocator of the set that owns the slab.
+ */
+static inline const CSetAllocator* allocator_of(CSet* set) {
+    if(set->slab_owner != NULL) set = set->slab_owner;
+    return set->extras != NULL ? set->extras->allocator : &default_allocator;
+}
+
+/* Functions: set_alloc, set_realloc, set_free
+ * -------------------------------------------
+ * Allocate, resize, and free memory belonging to the set, using the set's allocator.
+ */
+static inline void* set_alloc(CSet* set, size_t size) {
+    const CSetAllocator* allocator = allocator_of(set);
+    void* addr = allocator->alloc_fn(allocator->ctx, size);
+    assert(addr != NULL);
+    return addr;
+}
+
+static inline void* set_realloc(CSet* set, void* addr, size_t old_size, size_t new_size) {
+    const CSetAllocator* allocator = allocator_of(set);
+    addr = allocator->realloc_fn(allocator->ctx, addr, old_size, new_size);
+    assert(addr != NULL);
+    return addr;
+}
+
+static inline void set_free(CSet* set, void* addr) {
+    const CSetAllocator* allocator = allocator_of(set);
+    if(addr != NULL) allocator->free_fn(allocator->ctx, addr);
+}
+
+/* Function: attach_extras
+ * -----------------------
+ * Gives a set without extras a set of default extras that use the given allocator. A set in a slab that gets extras
+ * needs work when its owner is deleted, so the owner's slab is no longer trivial.
+ */
+static SetExtras* attach_extras(CSet* set, const CSetAllocator* allocator) {
+    SetExtras* extras = allocator->alloc_fn(allocator->ctx, sizeof(SetExtras));
+    assert(extras != NULL);
+    extras->allocator = allocator;
+    extras->policy = default_policy;
+    extras->refcount = 1;
+    extras->immutable = false;
+    extras->slab_trivial = false;
+    extras->intern_table = NULL;
+    extras->slabs = NULL;
+    extras->n_slabs = 0;
+    extras->slab_bytes = 0;
+    extras->free_records = NULL;
+    extras->record_next = NULL;
+    extras->records_left = 0;
+    extras->buffer_refs = NULL;
+    set->extras = extras;
+    if(set->slab_owner != NULL) set->slab_owner->extras->slab_trivial = false;
+    return extras;
+}
+
+/* Function: get_extras
+ * --------------------
+ * Returns the set's extras, attaching them first if the set has none yet.
+ */
+static inline SetExtras* get_extras(CSet* set) {
+    return set->extras != NULL ? set->extras : attach_extras(set, allocator_of(set));
+}
+
+/* Function: use_allocator
+ * -----------------------
+ * Records the allocator a newly initialized set was allocated from. Only sets with a custom allocator need extras to
+ * hold it.
+ */
+static void use_allocator(CSet* set, const CSetAllocator* allocator) {
+    if(allocator != NULL && allocator != &default_allocator) attach_extras(set, allocator);
+}
+
+/* Functions: policy_of, immutable, intern_table_of
+ * -------------------------------------------------
+ * Return the set's growth policy, whether the set is interned (and so can't be modified), and the intern table it is
+ * canonical in, if any.
+ */
+static inline const CSetGrowthPolicy* policy_of(CSet* set) {
+    return set->extras != NULL ? &set->extras->policy : &default_policy;
+}
+
+static inline bool immutable(CSet* set) {
+    return set->extras != NULL && set->extras->immutable;
+}
+
+static inline CSetInternTable* intern_table_of(CSet* set) {
+    return set->extras != NULL ? set->extras->intern_table : NULL;
+}
+
+/* Function: slot
+ * --------------
+ * Returns the address of the nth slot of the set's buffer, counting from the beginning of the buffer rather than
+ * from the first element.
+ */ 
+static inline void* slot(CSet* set, size_t n) {
+    return (char *)set->elements + (n * set->slotsz);
+}
+
 /* Function: nth
  * -------------
  * Returns the nth element of the elements array of the given set.
  */ 
 static inline void* nth(CSet* set, int n) {
-    return (char *)set->elements + (n * set->elemsz);
+    return slot(set, set->start + n);
 }
 
 /* Function: get_index
@@ -63,127 +333,909 @@ static inline void* nth(CSet* set, int n) {
  * Returns the index of the elem in the elements array of the given set.
  */ 
 static inline int get_index(CSet* set, void* elem) {
-    return ((char *)elem - (char *)set->elements) / set->elemsz;
+    return ((char *)elem - (char *)nth(set, 0)) / (int)set->slotsz;
 }
 
-/* Function: check_resize
- * ----------------------
- * Checks to see if the set's element array needs to be resized and resizes it if needed.
+/* Functions: elem_of, elem_at
+ * ----------------------------
+ * Return the client's element stored in the given slot, or in the nth slot. In an indirect set this is the record the
+ * slot points to; otherwise it is the slot itself.
+ */
+static inline void* elem_of(CSet* set, void* slot_addr) {
+    return set->indirect ? *(void **)slot_addr : slot_addr;
+}
+
+static inline void* elem_at(CSet* set, int n) {
+    return elem_of(set, nth(set, n));
+}
+
+/* Function: drop_buffer
+ * ---------------------
+ * Lets go of the set's elements array, freeing it unless it is borrowed from a slab or still shared with clones.
+ */
+static void drop_buffer(CSet* set) {
+    int* buffer_refs = set->extras != NULL ? set->extras->buffer_refs : NULL;
+    if(buffer_refs != NULL) {
+        if(__atomic_sub_fetch(buffer_refs, 1, __ATOMIC_ACQ_REL) == 0) {
+            set_free(set, buffer_refs);
+            set_free(set, set->elements);
+        }
+        set->extras->buffer_refs = NULL;
+    } else if(set->owns_elements) {
+        set_free(set, set->elements);
+    }
+}
+
+/* Function: relocate
+ * ------------------
+ * Moves the set's elements into a buffer of new_capacity slots so that the first element is at slot new_start.
+ * If the capacity is unchanged, the elements are shifted within the existing buffer, unless it is shared with clones.
+ * A buffer borrowed from a slab or shared with clones is left in place when the elements move out of it.
  */
-static inline void check_resize(CSet* set) {
-    if(set->n_elements >= (set->capacity - 1)) {
-        size_t new_capacity = set->capacity * RESIZE_FACTOR;
+static void relocate(CSet* set, size_t new_capacity, size_t new_start) {
+    size_t bytes = set->n_elements * set->slotsz;
+    if(new_capacity == set->capacity && (set->extras == NULL || set->extras->buffer_refs == NULL)) {
+        memmove(slot(set, new_start), nth(set, 0), bytes);
+    } else {
+        void* new_elements = set_alloc(set, new_capacity * set->slotsz);
+        memcpy((char *)new_elements + new_start * set->slotsz, nth(set, 0), bytes);
+        drop_buffer(set);
+        set->elements = new_elements;
+        set->owns_elements = true;
+        if(set->slab_owner != NULL) set->slab_owner->extras->slab_trivial = false;
         set->capacity = new_capacity;
-        set->elements = realloc(set->elements, set->elemsz * new_capacity);
     }
+    set->start = new_start;
+}
+
+/* Function: own_buffer
+ * --------------------
+ * Called before anything writes to the set's elements array. If the array is shared with clones, the set moves its
+ * elements into a private copy, or takes the array back if the clones have all let go of it.
+ */
+static inline void own_buffer(CSet* set) {
+    if(set->extras == NULL || set->extras->buffer_refs == NULL) return;
+    //Only the sets sharing the array can clone it, so once the count reaches 1 it stays there.
+    if(__atomic_load_n(set->extras->buffer_refs, __ATOMIC_ACQUIRE) == 1) {
+        set_free(set, set->extras->buffer_refs);
+        set->extras->buffer_refs = NULL;
+    } else {
+        relocate(set, set->capacity, set->start);
+    }
+}
+
+/* Function: grown_capacity
+ * -------------------------
+ * Returns the capacity the set's elements array grows to under its growth policy: the current capacity times the
+ * growth factor, limited to max_growth more slots if that is set, and in any case at least needed and at least one
+ * more than the current capacity.
+ */
+static size_t grown_capacity(CSet* set, size_t needed) {
+    const CSetGrowthPolicy* policy = policy_of(set);
+    size_t step = set->capacity * (policy->growth_factor - 1);
+    if(policy->max_growth > 0 && step > policy->max_growth) step = policy->max_growth;
+    if(step == 0) step = 1;
+    size_t new_capacity = set->capacity + step;
+    return new_capacity < needed ? needed : new_capacity;
+}
+
+/* Function: make_room
+ * -------------------
+ * Ensures there is a free slot before the first element (if at_front) or after the last element (otherwise). If
+ * that side is full but at least a quarter of the buffer is free, the elements are recentered in place; otherwise
+ * the buffer grows according to the set's growth policy and the elements are centered in it. Either way each side
+ * ends up with a share of the free space proportional to the capacity (or to the growth step, if it is bounded), so
+ * the cost of recentering is amortized over many inserts.
+ */
+static void make_room(CSet* set, bool at_front) {
+    size_t back_free = set->capacity - set->start - set->n_elements;
+    if(at_front ? set->start > 0 : back_free > 0) return;
+
+    size_t new_capacity = set->capacity;
+    size_t free_slots = set->capacity - set->n_elements;
+    bool crowded = free_slots * 4 < set->capacity;
+    //With a bounded growth step, half a step of free space is also enough to recenter, so the array stays within a
+    //step of the number of elements.
+    size_t max_growth = policy_of(set)->max_growth;
+    if(max_growth > 0 && free_slots * 2 >= max_growth) crowded = false;
+    if(crowded) new_capacity = grown_capacity(set, set->n_elements + 1);
+    //Splits the free space evenly, rounding in favor of the side that needs the slot.
+    free_slots = new_capacity - set->n_elements;
+    relocate(set, new_capacity, at_front ? (free_slots + 1) / 2 : free_slots / 2);
+}
+
+/* Function: ensure_capacity
+ * -------------------------
+ * Ensures that the set's buffer has room for at least needed elements starting from the first element, so that
+ * elements can be appended with a single memcpy. Grows the buffer according to the set's growth policy if necessary.
+ */
+static void ensure_capacity(CSet* set, size_t needed) {
+    if(set->start + needed <= set->capacity) return;
+    relocate(set, set->capacity >= needed ? set->capacity : grown_capacity(set, needed), 0);
+}
+
+/* Function: maybe_shrink
+ * ----------------------
+ * Called after elements are removed. If the set's growth policy has a shrink threshold and the set has fallen below
+ * it, shrinks the elements array to the growth factor times the number of elements and centers them. A buffer
+ * borrowed from a slab is left alone, since moving out of it would only use more memory.
+ */
+static void maybe_shrink(CSet* set) {
+    const CSetGrowthPolicy* policy = policy_of(set);
+    double threshold = policy->shrink_threshold;
+    if(threshold <= 0 || !set->owns_elements || set->n_elements >= set->capacity * threshold) return;
+    size_t new_capacity = set->n_elements * policy->growth_factor;
+    if(new_capacity == 0) new_capacity = 1;
+    if(new_capacity < set->capacity) relocate(set, new_capacity, (new_capacity - set->n_elements) / 2);
+}
+
+/* Function: add_slab
+ * ------------------
+ * Hands ownership of slab to set, which frees it when deleted.
+ */
+static void add_slab(CSet* set, void* slab) {
+    SetExtras* extras = get_extras(set);
+    extras->slabs = set_realloc(set, extras->slabs, extras->n_slabs * sizeof(void*),
+                                (extras->n_slabs + 1) * sizeof(void*));
+    extras->slabs[(extras->n_slabs)++] = slab;
+}
+
+/* Function: alloc_slab
+ * --------------------
+ * Allocates a slab of the given size from the set's allocator and hands it to the set.
+ */
+static void* alloc_slab(CSet* set, size_t bytes) {
+    void* slab = set_alloc(set, bytes);
+    add_slab(set, slab);
+    set->extras->slab_bytes += bytes;
+    return slab;
+}
+
+/* Function: record_size
+ * ---------------------
+ * Returns the size of a record in an indirect set's pool: the element size rounded up to a multiple of 8 bytes, and
+ * large enough to hold the free list link.
+ */
+static inline size_t record_size(CSet* set) {
+    size_t size = (set->elemsz + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+    return size < sizeof(void*) ? sizeof(void*) : size;
+}
+
+/* Function: record_alloc
+ * ----------------------
+ * Returns a free record from the indirect set's pool, reusing a freed record if there is one. When the newest chunk
+ * is used up, a new chunk is allocated with as many records as the set has slots, so the pool grows with the set.
+ */
+static void* record_alloc(CSet* set) {
+    SetExtras* extras = get_extras(set);
+    void* record = extras->free_records;
+    if(record != NULL) {
+        extras->free_records = *(void **)record;
+        return record;
+    }
+    if(extras->records_left == 0) {
+        extras->record_next = alloc_slab(set, set->capacity * record_size(set));
+        extras->records_left = set->capacity;
+    }
+    record = extras->record_next;
+    extras->record_next += record_size(set);
+    (extras->records_left)--;
+    return record;
+}
+
+/* Function: record_free
+ * ---------------------
+ * Returns a record to the indirect set's pool.
+ */
+static inline void record_free(CSet* set, void* record) {
+    *(void **)record = set->extras->free_records;
+    set->extras->free_records = record;
+}
+
+/* Function: copy_record
+ * ---------------------
+ * Makes the slot of an indirect set point to a copy of the record it currently points to, allocated from the set's
+ * own pool. Used when slots are copied from one set into another that must own its records.
+ */
+static inline void copy_record(CSet* set, void* slot_addr) {
+    void* record = record_alloc(set);
+    memcpy(record, *(void **)slot_addr, set->elemsz);
+    *(void **)slot_addr = record;
+}
+
+/* Function: release_records
+ * ---------------------------
+ * Frees every chunk of the indirect set's record pool and leaves the pool empty.
+ */
+static void release_records(CSet* set) {
+    SetExtras* extras = set->extras;
+    if(extras == NULL) return;
+    for(int i = 0; i < extras->n_slabs; i++) set_free(set, extras->slabs[i]);
+    set_free(set, extras->slabs);
+    extras->slabs = NULL;
+    extras->n_slabs = 0;
+    extras->slab_bytes = 0;
+    extras->free_records = NULL;
+    extras->record_next = NULL;
+    extras->records_left = 0;
+}
+
+/* Function: detach_from_slab
+ * ---------------------------
+ * Returns a copy of a set living in another set's slab that lives in memory of its own, with its elements moved out of
+ * the slab too if they are still there. The original header is abandoned in the slab, which is freed with the slab's
+ * owner as usual.
+ */
+static CSet* detach_from_slab(CSet* set) {
+    const CSetAllocator* allocator = allocator_of(set);
+    CSet* copy = allocator->alloc_fn(allocator->ctx, sizeof(CSet));
+    assert(copy != NULL);
+    *copy = *set;
+    copy->slab_owner = NULL;
+    if(copy->extras == NULL) use_allocator(copy, allocator);
+    if(!copy->owns_elements) {
+        void* elements = set_alloc(copy, copy->capacity * copy->slotsz);
+        memcpy((char *)elements + copy->start * copy->slotsz, nth(copy, 0), copy->n_elements * copy->slotsz);
+        copy->elements = elements;
+        copy->owns_elements = true;
+    }
+    return copy;
+}
+
+/* Function: adopt_slabs
+ * ---------------------
+ * Moves src's slabs into dst when src's slots have been moved into dst, so that they live as long as the elements
+ * that use them. In an indirect set the slabs are the record pool: if both sets have free records or partly used
+ * chunks, dst keeps its own and src's are only reclaimed when dst is deleted. Otherwise they hold the subsets of a
+ * power set, and the subsets among dst's elements from index first on are handed to dst. The slabs were allocated by
+ * src's allocator and will be freed by dst's, so the two must be the same.
+ */
+static void adopt_slabs(CSet* dst, CSet* src, int first) {
+    if(src->extras == NULL || src->extras->n_slabs == 0) return;
+    assert(allocator_of(dst) == allocator_of(src));
+    SetExtras* from = src->extras;
+    SetExtras* to = get_extras(dst);
+    for(int i = 0; i < from->n_slabs; i++) add_slab(dst, from->slabs[i]);
+    to->slab_bytes += from->slab_bytes;
+    if(dst->indirect) {
+        if(to->free_records == NULL) to->free_records = from->free_records;
+        if(to->records_left == 0) {
+            to->record_next = from->record_next;
+            to->records_left = from->records_left;
+        }
+    } else {
+        for(int i = first; i < dst->n_elements; i++) {
+            CSet* subset = *(CSet **)nth(dst, i);
+            if(subset->slab_owner == src) subset->slab_owner = dst;
+        }
+    }
+    //The slabs now belong to dst, so src only forgets them.
+    from->n_slabs = 0;
+    release_records(src);
+}
+
+/* Function: hashable
+ * ------------------
+ * Returns true if the set can hash its elements: with the client's hash function, or by their keys if the keys fully
+ * determine the order.
+ */
+static inline bool hashable(CSet* set) {
+    return set->hash_fn != NULL || (set->key_words > 0 && set->cmp_fn == NULL);
+}
+
+static CSet* create_keyed(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn, CompareFn cmp_fn,
+                          CleanupElemFn cleanup_fn, ToStringFn toString_fn, bool indirect,
+                          const CSetAllocator* allocator);
+static CSet* create_indirect(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                             ToStringFn toString_fn, const CSetAllocator* allocator);
+
+/* Function: create_like
+ * ---------------------
+ * Creates an empty set with the same element size, client functions, allocator, and storage as the given set (keyed,
+ * indirect, or both). Used by the operations that build new sets out of existing ones. A capacity of 0 is bumped to
+ * 1 so the default capacity isn't triggered.
+ */
+static CSet* create_like(CSet* set, size_t capacity) {
+    if(capacity == 0) capacity = 1;
+    CSet* copy;
+    if(set->key_words > 0) {
+        copy = create_keyed(set->elemsz, set->key_words * sizeof(uint64_t), capacity, set->key_fn, set->cmp_fn,
+                            set->cleanup_fn, set->toString_fn, set->indirect, allocator_of(set));
+    } else if(set->indirect) {
+        copy = create_indirect(set->elemsz, capacity, set->cmp_fn, set->cleanup_fn, set->toString_fn, allocator_of(set));
+    } else {
+        copy = cset_createWithAllocator(set->elemsz, capacity, set->cmp_fn, set->cleanup_fn, set->toString_fn,
+                                        allocator_of(set));
+    }
+    copy->hash_fn = set->hash_fn;
+    copy->hash_valid = hashable(copy);
+    //Only a policy other than the default needs extras to hold it.
+    const CSetGrowthPolicy* policy = policy_of(set);
+    if(memcmp(policy, &default_policy, sizeof(CSetGrowthPolicy)) != 0) get_extras(copy)->policy = *policy;
+    return copy;
+}
+
+/* Function: key_of
+ * ----------------
+ * Returns the normalized key stored with the given element of a keyed set.
+ */
+static inline uint64_t* key_of(CSet* set, const void* elem) {
+    return (uint64_t *)((char *)elem + set->slotsz) - set->key_words;
+}
+
+/* Function: key_compare
+ * ---------------------
+ * Compares two normalized keys of the given length, stored most significant word first.
+ */
+static inline int key_compare(const uint64_t* a, const uint64_t* b, int words) {
+    for(int w = 0; w < words; w++) {
+        if(a[w] != b[w]) return a[w] < b[w] ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Type Definition: Probe
+ * ----------------------
+ * An element being searched for. In a keyed set the element's key is encoded once, when the probe is made, so that
+ * searching only compares keys.
+ */
+typedef struct {
+    const void* elem;
+    uint64_t key[MAX_KEY_WORDS];
+} Probe;
+
+/* Function: make_probe
+ * --------------------
+ * Prepares a probe for elem in the given set. The key function writes big-endian bytes, which are read back as
+ * integers so that keys can be compared a word at a time.
+ */
+static inline void make_probe(CSet* set, const void* elem, Probe* probe) {
+    probe->elem = elem;
+    if(set->key_words == 0) return;
+    unsigned char bytes[MAX_KEY_WORDS * sizeof(uint64_t)] = {0};
+    set->key_fn(elem, bytes);
+    for(int w = 0; w < set->key_words; w++) {
+        uint64_t word = 0;
+        for(int b = 0; b < 8; b++) word = (word << 8) | bytes[w * 8 + b];
+        probe->key[w] = word;
+    }
+}
+
+/* Function: compare_at
+ * --------------------
+ * Compares the set's nth element with the probe, by key in a keyed set and with the set's comparator otherwise. If the
+ * keys are only prefixes, equal keys are resolved with the comparator.
+ */
+static inline int compare_at(CSet* set, int n, const Probe* probe) {
+    if(set->key_words > 0) {
+        int cmp_result = key_compare(key_of(set, nth(set, n)), probe->key, set->key_words);
+        if(cmp_result != 0 || set->cmp_fn == NULL) return cmp_result;
+    }
+    return set->cmp_fn(elem_at(set, n), probe->elem);
+}
+
+/* Function: compare_elements
+ * --------------------------
+ * Compares two elements stored in sets of the same type as set. Keyed sets compare the stored keys first.
+ */
+static inline int compare_elements(CSet* set, const void* elem1, const void* elem2) {
+    if(set->key_words > 0) {
+        int cmp_result = key_compare(key_of(set, elem1), key_of(set, elem2), set->key_words);
+        if(cmp_result != 0 || set->cmp_fn == NULL) return cmp_result;
+    }
+    return set->cmp_fn(elem_of(set, (void *)elem1), elem_of(set, (void *)elem2));
+}
+
+/* Function: mix_hash
+ * ------------------
+ * Scrambles the bits of h (this is the finalizer of the splitmix64 generator), so that summing the hashes of elements
+ * doesn't let simple patterns in the client's hashes cancel out.
+ */
+static inline uint64_t mix_hash(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111eb;
+    return h ^ (h >> 31);
+}
+
+/* Function: element_hash
+ * ----------------------
+ * Returns the mixed hash of the element in the given slot of a hashable set.
+ */
+static uint64_t element_hash(CSet* set, const void* elem) {
+    if(set->hash_fn != NULL) return mix_hash(set->hash_fn(elem_of(set, (void *)elem)));
+    uint64_t* key = key_of(set, elem);
+    uint64_t h = 0;
+    for(int w = 0; w < set->key_words; w++) h = mix_hash(h ^ key[w]);
+    return h;
+}
+
+/* Function: reset_hash
+ * --------------------
+ * Sets the hash of a set that has just become empty. The hash of no elements is 0.
+ */
+static inline void reset_hash(CSet* set) {
+    set->hash = 0;
+    set->hash_valid = hashable(set);
 }
 
 /* Function: insert
  * ----------------
- * Inserts the given element into the set's elements array at the given index. Used by cset_add.
+ * Inserts the given element into the set's elements array at the given index, along with its key if the set is keyed.
+ * Used by cset_add. Shifts whichever side of index holds fewer elements, so inserting near either end of the set is
+ * cheap. The inserted element may not be from the set's slabs, so the set can no longer skip cleanup when deleted. An
+ * indirect set copies the element into a record from its pool and stores a pointer to the record.
+ */
+static inline void insert(CSet* set, const void* elem, const uint64_t* key, int index) {
+    assert(!immutable(set));
+    own_buffer(set);
+    if(set->extras != NULL) set->extras->slab_trivial = false;
+    bool shift_front = index < set->n_elements - index;
+    make_room(set, shift_front);
+    if(shift_front) {
+        memmove(slot(set, set->start - 1), nth(set, 0), set->slotsz * index);
+        (set->start)--;
+    } else {
+        memmove(nth(set, index + 1), nth(set, index), set->slotsz * (set->n_elements - index));
+    }
+    void* ith = nth(set, index);
+    if(set->indirect) *(void **)ith = memcpy(record_alloc(set), elem, set->elemsz);
+    else memcpy(ith, elem, set->elemsz);
+    if(set->key_words > 0) memcpy(key_of(set, ith), key, set->key_words * sizeof(uint64_t));
+    if(set->hash_valid) set->hash += element_hash(set, ith);
+    (set->n_elements)++;
+}
+
+/* Function: less_at
+ * -----------------
+ * Returns true if the set's nth element is less than the probe. When a single-word key determines the order, this is
+ * one integer comparison.
+ */
+static inline bool less_at(CSet* set, int n, const Probe* probe) {
+    if(set->key_words == 1 && set->cmp_fn == NULL) return *key_of(set, nth(set, n)) < probe->key[0];
+    return compare_at(set, n, probe) < 0;
+}
+
+/* Function: search_address
+ * ------------------------
+ * Returns the address a search reads first when it compares against the nth element: the key in a keyed set, and the
+ * element otherwise.
+ */
+static inline const void* search_address(CSet* set, int n) {
+    return set->key_words > 0 ? (const void *)key_of(set, nth(set, n)) : nth(set, n);
+}
+
+/* Function: lower_bound_in
+ * ------------------------
+ * Returns the index of the first element in the range [low, high) of the set's elements array that is not less
+ * than the probe, or high if every element in the range is less than it. The caller guarantees that every element
+ * before low is less than the probe and every element from high onward is not.
+ *
+ * This is the search kernel behind every lookup and insertion. Each step halves the range and chooses the half with a
+ * conditional move rather than a branch, so random keys don't cause mispredictions and every search of a range takes
+ * the same number of steps. Ranges too large for the L1 cache also prefetch both elements the next step might compare
+ * against, so the memory access of the next step overlaps the comparison of this one.
  */
-static inline void insert(CSet* set, void* elem, int index) {
-    size_t elems_left = set->n_elements - index;
-    void* elem_dest = nth(set, index);
-    if(elems_left > 0) {
-        void* rest_dest = nth(set, index + 1);
-        memmove(rest_dest, elem_dest, set->elemsz * elems_left);
+static int lower_bound_in(CSet* set, const Probe* probe, int low, int high) {
+    if(low >= high) return low;
+    int base = low, n = high - low;
+    bool prefetch = (size_t)n * set->slotsz >= PREFETCH_MIN_BYTES;
+    while(n > 1) {
+        int half = n / 2;
+        if(prefetch) {
+            int next_half = (n - half) / 2;
+            __builtin_prefetch(search_address(set, base + next_half));
+            __builtin_prefetch(search_address(set, base + half + next_half));
+        }
+        base = less_at(set, base + half, probe) ? base + half : base;
+        n -= half;
     }
-    memcpy(elem_dest, elem, set->elemsz);
+    return base + less_at(set, base, probe);
+}
+
+/* Function: lower_bound
+ * ---------------------
+ * Returns the index of the first element in the set's elements array that is not less than the probe, or n_elements
+ * if every element is less than it. This is both the position of the probed element if it is contained in the set and
+ * the position at which it would be inserted otherwise.
+ */
+static inline int lower_bound(CSet* set, const Probe* probe) {
+    return lower_bound_in(set, probe, 0, set->n_elements);
+}
+
+/* Function: index_of
+ * ------------------
+ * Returns the index of the element equal to the probe, or -1 if the set doesn't contain one.
+ */
+static int index_of(CSet* set, const Probe* probe) {
+    int index = lower_bound(set, probe);
+    if(index < set->n_elements && compare_at(set, index, probe) == 0) return index;
+    return -1;
+}
+
+/* Function: position_of
+ * -----------------------
+ * Returns the index of an element returned to the client by one of the set's accessors. Its position in the elements
+ * array gives the index directly, except in an indirect set, where it has to be searched for.
+ */
+static int position_of(CSet* set, void* elem) {
+    if(!set->indirect) return get_index(set, elem);
+    Probe probe;
+    make_probe(set, elem, &probe);
+    return index_of(set, &probe);
 }
 
+/* Function: gallop_lower_bound
+ * ----------------------------
+ * Finds the same index as lower_bound, but starts from a guess (hint) and searches outward from it with doubling
+ * steps before finishing with a binary search. Costs O(log d) comparisons where d is the distance between the hint
+ * and the true position, so a good hint makes the search O(1).
+ */
+static int gallop_lower_bound(CSet* set, const Probe* probe, int hint) {
+    int n = set->n_elements;
+    if(hint < 0) hint = 0;
+    if(hint > n) hint = n;
+
+    if(hint > 0 && compare_at(set, hint - 1, probe) >= 0) {
+        //The position is before the hint. Gallops left until an element less than elem is found.
+        int high = hint - 1, step = 1;
+        int low = high - step;
+        while(low >= 0 && compare_at(set, low, probe) >= 0) {
+            high = low;
+            step *= 2;
+            low = high - step;
+        }
+        return lower_bound_in(set, probe, low < 0 ? 0 : low + 1, high);
+    }
+    if(hint < n && compare_at(set, hint, probe) < 0) {
+        //The position is after the hint. Gallops right until an element not less than elem is found.
+        int low = hint + 1, step = 1;
+        int high = low + step;
+        while(high <= n && compare_at(set, high - 1, probe) < 0) {
+            low = high;
+            step *= 2;
+            high = low + step;
+        }
+        return lower_bound_in(set, probe, low, high > n ? n : high - 1);
+    }
+    return hint;
+}
 
     /* * * * * Public Member Functions * * * * */
 
 
+/* Function: init_set
+ * -------------------
+ * Initializes the fields of set to an empty set using the given elements buffer and client functions.
+ */
+static void init_set(CSet* set, void* elements, size_t elemsz, size_t capacity, CompareFn cmp_fn,
+                     CleanupElemFn cleanup_fn, ToStringFn toString_fn) {
+    set->elements = elements;
+    set->start = 0;
+    set->n_elements = 0;
+    set->elemsz = elemsz;
+    set->slotsz = elemsz;
+    set->key_words = 0;
+    set->key_fn = NULL;
+    set->capacity = capacity;
+    set->cmp_fn = cmp_fn;
+    set->cleanup_fn = cleanup_fn;
+    set->toString_fn = toString_fn;
+    set->owns_elements = true;
+    set->slab_owner = NULL;
+    set->hash_fn = NULL;
+    set->hash = 0;
+    set->hash_valid = false;
+    set->indirect = false;
+    set->extras = NULL;
+}
+
+/* Function: init_slab_subset
+ * --------------------------
+ * Initializes header, which lives in a slab owned by owner, as an empty set with the same type as base whose elements
+ * array is the capacity slots at address elements, also within the slab.
+ */
+static void init_slab_subset(CSet* header, void* elements, size_t capacity, CSet* base, CSet* owner) {
+    init_set(header, elements, base->elemsz, capacity, base->cmp_fn, base->cleanup_fn, base->toString_fn);
+    header->slotsz = base->slotsz;
+    header->key_words = base->key_words;
+    header->key_fn = base->key_fn;
+    header->hash_fn = base->hash_fn;
+    header->owns_elements = false;
+    header->slab_owner = owner;
+}
+
+/* Function: intern_grow
+ * ---------------------
+ * Rehashes the table's sets into a table with more entries, using their cached hashes.
+ */
+static void intern_grow(CSetInternTable* table) {
+    InternEntry* old_entries = table->entries;
+    size_t old_capacity = table->capacity;
+    table->capacity *= RESIZE_FACTOR;
+    table->entries = calloc(table->capacity, sizeof(InternEntry));
+    assert(table->entries != NULL);
+    for(size_t i = 0; i < old_capacity; i++) {
+        if(old_entries[i].set == NULL) continue;
+        size_t j = old_entries[i].hash & (table->capacity - 1);
+        while(table->entries[j].set != NULL) j = (j + 1) & (table->capacity - 1);
+        table->entries[j] = old_entries[i];
+    }
+    free(old_entries);
+}
+
+/* Function: intern_remove
+ * -----------------------
+ * Removes set from the table. Entries after the hole that would no longer be reachable from their home slots are
+ * shifted back into it, so the table needs no tombstones.
+ */
+static void intern_remove(CSetInternTable* table, CSet* set) {
+    size_t mask = table->capacity - 1;
+    size_t i = set->hash & mask;
+    while(table->entries[i].set != set) i = (i + 1) & mask;
+    for(size_t j = (i + 1) & mask; table->entries[j].set != NULL; j = (j + 1) & mask) {
+        //Moves entry j into the hole at i unless its home slot lies cyclically in (i, j].
+        size_t home = table->entries[j].hash & mask;
+        if(((j - home) & mask) >= ((j - i) & mask)) {
+            table->entries[i] = table->entries[j];
+            i = j;
+        }
+    }
+    table->entries[i].set = NULL;
+    (table->n_sets)--;
+}
+
 /* Function: cset_create
  * ---------------------
  * Allocates memory for a set and initializes its fields using the client-supplied values/functions.
  */ 
 CSet* cset_create(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn, ToStringFn toString_fn) {
+    return cset_createWithAllocator(elemsz, capacity_hint, cmp_fn, cleanup_fn, toString_fn, NULL);
+}
+
+/* Function: new_set
+ * -----------------
+ * Allocates a set header and an elements array of capacity slots of slotsz bytes from the given allocator (or the
+ * default allocator if it is NULL). The header is left for the caller to initialize, and then to hand to use_allocator.
+ */
+static CSet* new_set(size_t slotsz, size_t capacity, const CSetAllocator* allocator, void** elements) {
+    if(allocator == NULL) allocator = &default_allocator;
+    CSet* set = allocator->alloc_fn(allocator->ctx, sizeof(CSet));
+    *elements = allocator->alloc_fn(allocator->ctx, slotsz * capacity);
+    assert(set != NULL && *elements != NULL);
+    return set;
+}
+
+/* Function: cset_createWithAllocator
+ * ----------------------------------
+ * The allocator is recorded after init_set, which leaves the set with the default one.
+ */
+CSet* cset_createWithAllocator(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                               ToStringFn toString_fn, const CSetAllocator* allocator) {
     //Ensures that comparator function is non-null. Comparator must be valid for this implementation to work.
     assert(cmp_fn != NULL);
     //Assigns the initial capacity to a predetermined default if 0 is passed as capacity_hint.
     size_t capacity = capacity_hint == 0 ? DEFAULT_CAPACITY : capacity_hint;
 
-    CSet* set = malloc(sizeof(CSet));
-    set->elements = malloc(elemsz * capacity);
+    void* elements;
+    CSet* set = new_set(elemsz, capacity, allocator, &elements);
+    init_set(set, elements, elemsz, capacity, cmp_fn, cleanup_fn, toString_fn);
+    use_allocator(set, allocator);
 
-    assert(set != NULL && set->elements != NULL);
+    return set;
+}
 
-    set->n_elements = 0;
-    set->elemsz = elemsz;
-    set->capacity = capacity;
-    set->cmp_fn = cmp_fn;
-    set->cleanup_fn = cleanup_fn;
-    set->toString_fn = toString_fn;
+/* Function: create_indirect
+ * -------------------------
+ * Creates an indirect set ordered by a comparator, whose slots are just record pointers.
+ */
+static CSet* create_indirect(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                             ToStringFn toString_fn, const CSetAllocator* allocator) {
+    assert(cmp_fn != NULL);
+    size_t capacity = capacity_hint == 0 ? DEFAULT_CAPACITY : capacity_hint;
+
+    void* elements;
+    CSet* set = new_set(sizeof(void*), capacity, allocator, &elements);
+    init_set(set, elements, elemsz, capacity, cmp_fn, cleanup_fn, toString_fn);
+    use_allocator(set, allocator);
+    set->slotsz = sizeof(void*);
+    set->indirect = true;
 
     return set;
 }
 
+/* Function: cset_createIndirect
+ * -----------------------------
+ * Comparisons dereference the record pointers, so every search step reads a record as well as a slot.
+ */
+CSet* cset_createIndirect(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                          ToStringFn toString_fn) {
+    return create_indirect(elemsz, capacity_hint, cmp_fn, cleanup_fn, toString_fn, NULL);
+}
+
+/* Function: create_keyed
+ * ----------------------
+ * Creates a set with room for a key after each element. The element part of each slot is padded to a multiple of 8
+ * bytes so that the keys are aligned. cmp_fn is NULL if the keys fully determine the order, and breaks ties between
+ * equal keys otherwise. In an indirect set the element part is a record pointer.
+ */
+static CSet* create_keyed(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn, CompareFn cmp_fn,
+                          CleanupElemFn cleanup_fn, ToStringFn toString_fn, bool indirect,
+                          const CSetAllocator* allocator) {
+    assert(key_fn != NULL && keysz > 0 && keysz <= MAX_KEY_WORDS * sizeof(uint64_t));
+    size_t capacity = capacity_hint == 0 ? DEFAULT_CAPACITY : capacity_hint;
+    int key_words = (keysz + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    size_t partsz = indirect ? sizeof(void*) : elemsz;
+    size_t slotsz = (partsz + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t) + key_words * sizeof(uint64_t);
+
+    void* elements;
+    CSet* set = new_set(slotsz, capacity, allocator, &elements);
+    init_set(set, elements, elemsz, capacity, cmp_fn, cleanup_fn, toString_fn);
+    use_allocator(set, allocator);
+    set->slotsz = slotsz;
+    set->key_words = key_words;
+    set->key_fn = key_fn;
+    set->indirect = indirect;
+    set->hash_valid = hashable(set);
+
+    return set;
+}
+
+/* Function: cset_createKeyed
+ * --------------------------
+ * Keys of a keyed set fully determine its order, so it has no comparator.
+ */
+CSet* cset_createKeyed(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn, CleanupElemFn cleanup_fn,
+                       ToStringFn toString_fn) {
+    return create_keyed(elemsz, keysz, capacity_hint, key_fn, NULL, cleanup_fn, toString_fn, false, NULL);
+}
+
+/* Function: cset_createKeyedIndirect
+ * ----------------------------------
+ * The slots of an indirect set hold a record pointer followed by the key.
+ */
+CSet* cset_createKeyedIndirect(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn,
+                               CleanupElemFn cleanup_fn, ToStringFn toString_fn) {
+    return create_keyed(elemsz, keysz, capacity_hint, key_fn, NULL, cleanup_fn, toString_fn, true, NULL);
+}
+
+/* Function: string_prefix
+ * -----------------------
+ * Key function for string sets: copies up to the first 8 bytes of the string, stopping at its terminator. The rest of
+ * the key is already zero, and comparing bytes as unsigned values agrees with strcmp.
+ */
+static void string_prefix(const void* addr, void* key) {
+    const char* str = *(const char **)addr;
+    for(int i = 0; i < 8 && str[i] != '\0'; i++) ((char *)key)[i] = str[i];
+}
+
+/* Function: compare_strings
+ * -------------------------
+ * Tie-breaking comparator for string sets, used only when two strings share their first 8 bytes.
+ */
+static int compare_strings(const void* addr1, const void* addr2) {
+    return strcmp(*(const char **)addr1, *(const char **)addr2);
+}
+
+/* Function: cset_createStringSet
+ * ------------------------------
+ * A string set is a keyed set whose keys are string prefixes, with strcmp to break ties.
+ */
+CSet* cset_createStringSet(size_t capacity_hint, CleanupElemFn cleanup_fn, ToStringFn toString_fn) {
+    return create_keyed(sizeof(char*), 8, capacity_hint, string_prefix, compare_strings, cleanup_fn, toString_fn, false,
+                        NULL);
+}
+
+/* Functions: cset_encodeUint64, cset_encodeInt64, cset_encodeDouble
+ * -----------------------------------------------------------------
+ * Flipping the sign bit moves negative integers below positive ones when compared as unsigned values. For doubles,
+ * flipping every bit of a negative value also reverses the order of negative magnitudes.
+ */
+void cset_encodeUint64(void* key, uint64_t value) {
+    unsigned char* bytes = key;
+    for(int b = 0; b < 8; b++) bytes[b] = value >> (56 - 8 * b);
+}
+
+void cset_encodeInt64(void* key, int64_t value) {
+    cset_encodeUint64(key, (uint64_t)value ^ ((uint64_t)1 << 63));
+}
+
+void cset_encodeDouble(void* key, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    cset_encodeUint64(key, bits >> 63 ? ~bits : bits | ((uint64_t)1 << 63));
+}
+
 /* Function: cset_delete
  * ---------------------
- * Frees all memory associated with a set, calling the client's cleanup function if it exists.
+ * Frees all memory associated with a set, calling the client's cleanup function if it exists. A set that lives in
+ * a slab only releases memory it allocated itself; the slab is freed along with the set that owns it. A power set
+ * whose subsets have not been modified is therefore deleted in O(1) time.
  */ 
 void cset_delete(CSet* set) {
-    //If the client has supplied a cleanup function, calls it on each element of the set.
-    if(set->cleanup_fn != NULL) {
+    SetExtras* extras = set->extras;
+    //A retained set is only deleted when its last reference is released. An interned set then leaves its table.
+    if(extras != NULL) {
+        if(--(extras->refcount) > 0) return;
+        if(extras->intern_table != NULL) intern_remove(extras->intern_table, set);
+    }
+    //If the client has supplied a cleanup function, calls it on each element of the set, unless the elements are all
+    //untouched sets in this set's slabs, in which case freeing the slabs releases everything.
+    if(set->cleanup_fn != NULL && (extras == NULL || !extras->slab_trivial)) {
         for(int i = 0; i < set->n_elements; i++) {
-            set->cleanup_fn(nth(set, i));
+            set->cleanup_fn(elem_at(set, i));
         }
     }
-    //Frees the elements array and the set struct itself.
-    free(set->elements);
-    free(set);
+    //Frees any slabs (or record chunks) owned by this set, then the elements array, and finally the set struct itself
+    //and its extras, which hold the allocator they are freed with.
+    release_records(set);
+    drop_buffer(set);
+    const CSetAllocator* allocator = allocator_of(set);
+    if(set->slab_owner == NULL) allocator->free_fn(allocator->ctx, set);
+    if(extras != NULL) allocator->free_fn(allocator->ctx, extras);
 }
 
 /* Function: cset_add
  * ------------------
  * Adds an element to the given set. If the set already contains that element, returns false to indicate that nothing
  * was added. Uses a binay searching algorithm to find the index where the element should be inserted. Resizes the
- * elements array if necessary and increments the element count.
+ * elements array if necessary and increments the element count. The greatest element is checked first, so adding
+ * elements in ascending order appends each in O(1) time.
  */ 
 bool cset_add(CSet* set, void* elem) {
-    //Uses a binary searching algorithm to find where elem should go in the array, then inserts it.
-    int partial_sz = set->n_elements;
-    int index = partial_sz / 2;
-    int cmp_result = 0;
-    while(partial_sz > 1) {
-        cmp_result = set->cmp_fn(elem, nth(set, index));
-        partial_sz /= 2;
-        //If the set already contains the given element, does nothing and returns false.
+    Probe probe;
+    make_probe(set, elem, &probe);
+    //Fast path for ascending input: an element greater than the current greatest is appended without searching.
+    int n = set->n_elements;
+    if(n > 0) {
+        int cmp_result = compare_at(set, n - 1, &probe);
         if(cmp_result == 0) return false;
-        //If elem is greater than the item at index, searches upper part of array. Otherwise, searches lower part.
-        if(cmp_result > 0) {
-            index += partial_sz / 2;
-        } else {
-            index -= partial_sz / 2;
+        if(cmp_result < 0) {
+            insert(set, elem, probe.key, n);
+            return true;
         }
+        n--;
     }
-    //A brief linear search at the end to catch any problems from integer division (index always conservatively low after above search).
-    if(index == 1) index = 0;
-    while(index < set->n_elements) {
-        if(set->cmp_fn(elem, nth(set, index)) > 0) index++;
-        else break;
-    }
-    //Checks for resize, inserts the element, and increases the element count of the set.
-    check_resize(set);
-    insert(set, elem, index);
-    (set->n_elements)++;
+    //Uses a binary searching algorithm to find where elem should go in the array, then inserts it.
+    int index = lower_bound_in(set, &probe, 0, n);
+    //If the set already contains the given element, does nothing and returns false.
+    if(index < n && compare_at(set, index, &probe) == 0) return false;
+    //Inserts the element, which resizes if needed and increases the element count of the set.
+    insert(set, elem, probe.key, index);
+    return true;
+}
+
+/* Function: cset_addHint
+ * ----------------------
+ * Like cset_add, but searches outward from the client's guess at elem's position instead of bisecting the whole array.
+ * For nearly-sorted input, where each element lands close to the previous one, insertion costs O(1) comparisons.
+ */
+bool cset_addHint(CSet* set, void* elem, int hint_position) {
+    Probe probe;
+    make_probe(set, elem, &probe);
+    int index = gallop_lower_bound(set, &probe, hint_position);
+    if(index < set->n_elements && compare_at(set, index, &probe) == 0) return false;
+    insert(set, elem, probe.key, index);
     return true;
 }
 
 /* Function: cset_clear
  * --------------------
- * Removes all elements from the set and returns the element count to zero. Does not alter the capacity.
+ * Removes all elements from the set and returns the element count to zero. Does not alter the capacity. An indirect
+ * set frees its whole record pool.
  */ 
 void cset_clear(CSet* set) {
+    assert(!immutable(set));
     if(set->cleanup_fn != NULL) {
         for(int i = 0; i < set->n_elements; i++) {
-            set->cleanup_fn(nth(set, i));
+            set->cleanup_fn(elem_at(set, i));
         }
     }
+    if(set->indirect) release_records(set);
     set->n_elements = 0;
+    reset_hash(set);
+    maybe_shrink(set);
 }
 
 /* Function: cset_contains
@@ -192,27 +1244,117 @@ void cset_clear(CSet* set) {
  * to determine whether the given element is in a set.
  */
 bool cset_contains(CSet* set, void* elem) {
-    return bsearch(elem, set->elements, set->n_elements, set->elemsz, set->cmp_fn) != NULL;
+    return cset_find(set, elem) != NULL;
+}
+
+/* Function: cset_find
+ * -------------------
+ * Binary searches for elem, the same way cset_contains does, and returns the stored copy if found.
+ */
+void* cset_find(CSet* set, void* elem) {
+    Probe probe;
+    make_probe(set, elem, &probe);
+    int index = index_of(set, &probe);
+    return index < 0 ? NULL : elem_at(set, index);
 }
 
 /* Function: cset_remove
  * ---------------------
  * Uses binary search to find elem in the given set. If elem is not found, returns false. If found,
- * uses memmove to overwrite elem and decrease the size of the array, decrements element count,
- * and return true.
+ * removes it with cset_removeRange, which calls the cleanup function and closes the gap, and returns true.
  */ 
 bool cset_remove(CSet* set, void* elem) {
-    void* found = bsearch(elem, set->elements, set->n_elements, set->elemsz, set->cmp_fn);
-    if(found == NULL) return false;
-    
-    //Calculates distance between found and base of array.
-    int index = get_index(set, found);
-    int bytes_left = (set->n_elements - index) * set->elemsz;
-    memmove(found, nth(set, index + 1), bytes_left);
+    Probe probe;
+    make_probe(set, elem, &probe);
+    int index = index_of(set, &probe);
+    if(index < 0) return false;
+
+    cset_removeRange(set, index, index + 1);
+    return true;
+}
+
+/* Function: cset_removeRange
+ * --------------------------
+ * Removes the elements at indices i through j - 1. Takes each removed element out of the set's hash and calls the
+ * client's cleanup function on it (returning it to the pool, in an indirect set), and then closes the gap with a
+ * single memmove of whichever side of the span holds fewer elements.
+ */
+void cset_removeRange(CSet* set, int i, int j) {
+    assert(0 <= i && i <= j && j <= set->n_elements && !immutable(set));
+    own_buffer(set);
+    if(set->cleanup_fn != NULL || set->hash_valid || set->indirect) {
+        for(int k = i; k < j; k++) {
+            void* kth = nth(set, k);
+            if(set->hash_valid) set->hash -= element_hash(set, kth);
+            if(set->cleanup_fn != NULL) set->cleanup_fn(elem_of(set, kth));
+            if(set->indirect) record_free(set, *(void **)kth);
+        }
+    }
+    if(i < set->n_elements - j) {
+        memmove(nth(set, j - i), nth(set, 0), i * set->slotsz);
+        set->start += j - i;
+    } else {
+        memmove(nth(set, i), nth(set, j), (set->n_elements - j) * set->slotsz);
+    }
+    set->n_elements -= j - i;
+    maybe_shrink(set);
+}
+
+/* Functions: cset_popFirst, cset_popLast
+ * --------------------------------------
+ * Removes the least or greatest element of the set in O(1) time by adjusting the start offset or element count
+ * (amortized O(1) if the growth policy shrinks the set). If out is non-NULL, the element is copied there and
+ * ownership passes to the client, so the cleanup function is not called; otherwise the element is cleaned up. Returns
+ * false if the set was empty.
+ */
+bool cset_popFirst(CSet* set, void* out) {
+    assert(!immutable(set));
+    if(set->n_elements == 0) return false;
+    void* first = nth(set, 0);
+    if(set->hash_valid) set->hash -= element_hash(set, first);
+    if(out != NULL) memcpy(out, elem_of(set, first), set->elemsz);
+    else if(set->cleanup_fn != NULL) set->cleanup_fn(elem_of(set, first));
+    if(set->indirect) record_free(set, *(void **)first);
+    (set->start)++;
+    (set->n_elements)--;
+    maybe_shrink(set);
+    return true;
+}
+
+bool cset_popLast(CSet* set, void* out) {
+    assert(!immutable(set));
+    if(set->n_elements == 0) return false;
+    void* last = nth(set, set->n_elements - 1);
+    if(set->hash_valid) set->hash -= element_hash(set, last);
+    if(out != NULL) memcpy(out, elem_of(set, last), set->elemsz);
+    else if(set->cleanup_fn != NULL) set->cleanup_fn(elem_of(set, last));
+    if(set->indirect) record_free(set, *(void **)last);
     (set->n_elements)--;
+    maybe_shrink(set);
     return true;
 }
 
+/* Function: cset_at
+ * -----------------
+ * Since the elements are stored contiguously in sorted order, the element of rank i is simply the ith element
+ * of the array. Returns NULL if i is out of range.
+ */
+void* cset_at(CSet* set, int i) {
+    if(i < 0 || i >= set->n_elements) return NULL;
+    return elem_at(set, i);
+}
+
+/* Function: cset_rank
+ * -------------------
+ * Returns the number of elements in the set that are less than elem, found by binary search. If elem is in the
+ * set, this is its index, so cset_at(set, cset_rank(set, elem)) returns the stored copy of elem.
+ */
+int cset_rank(CSet* set, void* elem) {
+    Probe probe;
+    make_probe(set, elem, &probe);
+    return lower_bound(set, &probe);
+}
+
 /* Function: cset_size
  * -------------------
  * Returns the number of elements in the set.
@@ -237,6 +1379,85 @@ bool cset_isEmpty(CSet* set) {
     return set->n_elements == 0;
 }
 
+/* Function: cset_capacity
+ * -----------------------
+ * Returns the number of slots in the set's elements array.
+ */
+size_t cset_capacity(CSet* set) {
+    return set->capacity;
+}
+
+/* Function: cset_reserve
+ * ----------------------
+ * make_room grows the array whenever less than a quarter of it is free, so reserving room for n elements allocates
+ * an extra third of n. The elements are centered in the new array.
+ */
+void cset_reserve(CSet* set, size_t n) {
+    assert(!immutable(set));
+    size_t new_capacity = n + (n + 2) / 3;
+    if(new_capacity <= set->capacity) return;
+    relocate(set, new_capacity, (new_capacity - set->n_elements) / 2);
+}
+
+/* Function: cset_shrinkToFit
+ * --------------------------
+ * Moves the elements into an array of exactly their number of slots. A buffer borrowed from a slab is already exactly
+ * sized, so it is left in place.
+ */
+void cset_shrinkToFit(CSet* set) {
+    assert(!immutable(set));
+    size_t new_capacity = set->n_elements == 0 ? 1 : set->n_elements;
+    if(new_capacity < set->capacity && set->owns_elements) relocate(set, new_capacity, 0);
+}
+
+/* Function: cset_memoryUsage
+ * --------------------------
+ * Memory that lives in a slab is counted once, by the set that owns the slab, so the subsets of an untouched power set
+ * contribute nothing beyond their owner's slabs. An elements array shared with clones is counted once by splitting it
+ * and its reference count evenly between the sets sharing it. Recursion follows the nesting of the sets, using only
+ * the stack.
+ */
+CSetMemoryUsage cset_memoryUsage(CSet* set, bool recursive) {
+    CSetMemoryUsage usage;
+    SetExtras* extras = set->extras;
+    usage.header_bytes = set->slab_owner != NULL ? 0 : sizeof(CSet);
+    usage.allocated_bytes = 0;
+    if(extras != NULL) {
+        usage.header_bytes += sizeof(SetExtras);
+        usage.allocated_bytes += extras->slab_bytes + extras->n_slabs * sizeof(void*);
+    }
+    size_t array_bytes = set->owns_elements ? set->capacity * set->slotsz : 0;
+    usage.used_bytes = set->n_elements * set->slotsz;
+    if(extras != NULL && extras->buffer_refs != NULL) {
+        int sharers = __atomic_load_n(extras->buffer_refs, __ATOMIC_ACQUIRE);
+        array_bytes = (array_bytes + sizeof(int)) / sharers;
+        usage.used_bytes /= sharers;
+    }
+    usage.allocated_bytes += array_bytes;
+    if(set->indirect) usage.used_bytes += set->n_elements * record_size(set);
+    usage.children_bytes = 0;
+    if(recursive && set->cmp_fn == cset_compare) {
+        for(int i = 0; i < set->n_elements; i++) {
+            CSetMemoryUsage child = cset_memoryUsage(*(CSet **)elem_at(set, i), true);
+            usage.children_bytes += child.header_bytes + child.allocated_bytes + child.children_bytes;
+        }
+    }
+    return usage;
+}
+
+/* Function: cset_setGrowthPolicy
+ * ------------------------------
+ * Checks that the policy can't make the set oscillate between growing and shrinking, then applies its shrink
+ * threshold right away. A set without extras already has the default policy, so restoring it attaches none.
+ */
+void cset_setGrowthPolicy(CSet* set, const CSetGrowthPolicy* policy) {
+    if(policy == NULL) policy = &default_policy;
+    assert(policy->growth_factor > 1 && policy->shrink_threshold >= 0);
+    assert(policy->shrink_threshold * policy->growth_factor < 1);
+    if(policy != &default_policy || set->extras != NULL) get_extras(set)->policy = *policy;
+    if(!immutable(set)) maybe_shrink(set);
+}
+
 /* Function: cset_isSubsetOf
  * -------------------------
  * Returns true if set1 is a subset of set2, i.e. if set2 contains all of the elements that are in set2.
@@ -247,11 +1468,162 @@ bool cset_isSubsetOf(CSet* set1, CSet* set2) {
     if(set1 == set2) return true;
 
     for(int i = 0; i < set1->n_elements; i++) {
-        if(!cset_contains(set2, nth(set1, i))) return false;
+        if(!cset_contains(set2, elem_at(set1, i))) return false;
+    }
+    return true;
+}
+
+/* Function: cset_setHashFn
+ * ------------------------
+ * Installs the hash function and invalidates the hash, which is computed on the next call to cset_hash.
+ */
+void cset_setHashFn(CSet* set, HashFn hash_fn) {
+    assert(!immutable(set));
+    set->hash_fn = hash_fn;
+    set->hash_valid = false;
+}
+
+/* Function: cset_hash
+ * -------------------
+ * Returns the maintained hash, recomputing it first if a bulk operation invalidated it.
+ */
+uint64_t cset_hash(CSet* set) {
+    assert(hashable(set));
+    if(!set->hash_valid) {
+        set->hash = 0;
+        for(int i = 0; i < set->n_elements; i++) {
+            set->hash += element_hash(set, nth(set, i));
+        }
+        set->hash_valid = true;
+    }
+    return set->hash;
+}
+
+/* Function: cset_equals
+ * ---------------------
+ * Checks the cheap criteria first: size, then element size, then (if both sets are hashable) their hashes. Only sets
+ * that agree on all of these are compared element by element.
+ */
+bool cset_equals(CSet* set1, CSet* set2) {
+    if(set1 == set2) return true;
+    //Distinct sets interned in the same table must differ.
+    if(intern_table_of(set1) != NULL && intern_table_of(set1) == intern_table_of(set2)) return false;
+    if(set1->n_elements != set2->n_elements || set1->elemsz != set2->elemsz) return false;
+    //A set and an unmodified clone share their elements.
+    if(set1->elements == set2->elements && set1->start == set2->start) return true;
+    if(hashable(set1) && hashable(set2) && cset_hash(set1) != cset_hash(set2)) return false;
+    for(int i = 0; i < set1->n_elements; i++) {
+        if(compare_elements(set1, nth(set1, i), nth(set2, i)) != 0) return false;
     }
     return true;
 }
 
+/* Function: cset_retain
+ * ---------------------
+ * Sets in slabs are freed with their slab regardless of references, so they can't be retained.
+ */
+CSet* cset_retain(CSet* set) {
+    assert(set->slab_owner == NULL);
+    (get_extras(set)->refcount)++;
+    return set;
+}
+
+/* Function: cset_clone
+ * --------------------
+ * Copies the header and shares the elements array, creating the shared count if this is the array's first clone. The
+ * clone is an ordinary mutable set even if the original is interned. Arrays borrowed from slabs and the records of
+ * indirect sets belong to another set or to the original, so those sets are copied instead.
+ */
+CSet* cset_clone(CSet* set) {
+    if(!set->owns_elements || set->indirect) {
+        CSet* copy = create_like(set, set->n_elements);
+        memcpy(nth(copy, 0), nth(set, 0), set->n_elements * set->slotsz);
+        copy->n_elements = set->n_elements;
+        if(set->indirect) {
+            for(int i = 0; i < copy->n_elements; i++) copy_record(copy, nth(copy, i));
+        }
+        copy->cleanup_fn = NULL;
+        copy->hash = set->hash;
+        copy->hash_valid = set->hash_valid;
+        return copy;
+    }
+
+    SetExtras* extras = get_extras(set);
+    if(extras->buffer_refs == NULL) {
+        extras->buffer_refs = set_alloc(set, sizeof(int));
+        *extras->buffer_refs = 1;
+    }
+    __atomic_add_fetch(extras->buffer_refs, 1, __ATOMIC_RELAXED);
+    CSet* clone = set_alloc(set, sizeof(CSet));
+    *clone = *set;
+    clone->cleanup_fn = NULL;
+    clone->slab_owner = NULL;
+    clone->extras = NULL;
+    SetExtras* clone_extras = attach_extras(clone, allocator_of(set));
+    clone_extras->policy = extras->policy;
+    clone_extras->buffer_refs = extras->buffer_refs;
+    return clone;
+}
+
+/* Function: cset_internTableCreate
+ * --------------------------------
+ * Sizes the table to the smallest power of two that keeps capacity_hint sets at most half full.
+ */
+CSetInternTable* cset_internTableCreate(size_t capacity_hint) {
+    CSetInternTable* table = malloc(sizeof(CSetInternTable));
+    assert(table != NULL);
+    table->capacity = DEFAULT_CAPACITY;
+    while(table->capacity < 2 * capacity_hint) table->capacity *= 2;
+    table->entries = calloc(table->capacity, sizeof(InternEntry));
+    assert(table->entries != NULL);
+    table->n_sets = 0;
+    return table;
+}
+
+/* Function: cset_internTableDelete
+ * --------------------------------
+ * Detaches the remaining sets from the table before freeing it, so that deleting them later doesn't touch the table.
+ */
+void cset_internTableDelete(CSetInternTable* table) {
+    for(size_t i = 0; i < table->capacity; i++) {
+        if(table->entries[i].set != NULL) table->entries[i].set->extras->intern_table = NULL;
+    }
+    free(table->entries);
+    free(table);
+}
+
+/* Function: cset_intern
+ * ---------------------
+ * Looks set up by its hash, comparing it only with interned sets of the same hash. A set that becomes canonical has its
+ * elements array shrunk to fit, since it will never grow again.
+ */
+CSet* cset_intern(CSetInternTable* table, CSet* set) {
+    if(intern_table_of(set) == table) return set;
+    assert(intern_table_of(set) == NULL && set->slab_owner == NULL);
+    uint64_t hash = cset_hash(set);
+    size_t mask = table->capacity - 1;
+    size_t i = hash & mask;
+    for(; table->entries[i].set != NULL; i = (i + 1) & mask) {
+        CSet* canonical = table->entries[i].set;
+        if(table->entries[i].hash == hash && cset_equals(canonical, set)) {
+            cset_delete(set);
+            (canonical->extras->refcount)++;
+            return canonical;
+        }
+    }
+
+    size_t capacity = set->n_elements == 0 ? 1 : set->n_elements;
+    if(set->capacity > capacity) relocate(set, capacity, 0);
+    SetExtras* extras = get_extras(set);
+    extras->immutable = true;
+    extras->intern_table = table;
+    table->entries[i].hash = hash;
+    table->entries[i].set = set;
+    (table->n_sets)++;
+    if(2 * table->n_sets > table->capacity) intern_grow(table);
+    return set;
+}
+
 /* Function: cset_union
  * --------------------
  * Returns the union of set1 and set2: a set containing every element from each set. Always
@@ -264,14 +1636,14 @@ CSet* cset_union(CSet* set1, CSet* set2) {
     if(set1 == NULL || set2 == NULL) return NULL;
     assert(set1->elemsz == set2->elemsz);
 
-    CSet* u = cset_create(set1->elemsz, set1->capacity, set1->cmp_fn, set1->cleanup_fn, set1->toString_fn);
+    CSet* u = create_like(set1, set1->capacity);
 
     for(int i = 0; i < set1->n_elements; i++) {
-        cset_add(u, nth(set1, i));
+        cset_add(u, elem_at(set1, i));
     }
 
     for(int i = 0; i < set2->n_elements; i++) {
-        cset_add(u, nth(set2, i));
+        cset_add(u, elem_at(set2, i));
     }
 
     return u;
@@ -288,12 +1660,12 @@ CSet* cset_intersect(CSet* set1, CSet* set2) {
     if(set1 == NULL || set2 == NULL) return NULL;
     assert(set1->elemsz == set2->elemsz);
 
-    CSet* intersect = cset_create(set1->elemsz, set1->capacity, set1->cmp_fn, set1->cleanup_fn, set1->toString_fn);
+    CSet* intersect = create_like(set1, set1->capacity);
     
     //Traverses the elements array of the smaller set and adds elements-in-common with set2 to the intersect set. 
     int smaller_sz = set1->n_elements < set2->n_elements ? set1->n_elements : set2->n_elements;
     for(int i = 0; i < smaller_sz; i++) {
-        void* ith = nth(set1, i);
+        void* ith = elem_at(set1, i);
         if(cset_contains(set2, ith)) cset_add(intersect, ith);
     }
 
@@ -310,10 +1682,10 @@ CSet* cset_difference(CSet* set1, CSet* set2) {
     if(set1 == NULL || set2 == NULL) return NULL;
     assert(set1->elemsz == set2->elemsz);
 
-    CSet* diff = cset_create(set1->elemsz, set1->capacity, set1->cmp_fn, set1->cleanup_fn, set1->toString_fn);
+    CSet* diff = create_like(set1, set1->capacity);
 
     for(int i = 0; i < set1->n_elements; i++) {
-        if(!cset_contains(set2, nth(set1, i))) cset_add(diff, nth(set1, i));
+        if(!cset_contains(set2, elem_at(set1, i))) cset_add(diff, elem_at(set1, i));
     }
 
     return diff;
@@ -334,59 +1706,772 @@ CSet* cset_symmetricDifference(CSet* set1, CSet* set2) {
     return symm_diff;
 }
 
+/* Function: cset_split
+ * ---------------------
+ * Partitions the set around pivot. Because the elements are ordered, one binary search finds the split index, and
+ * each half is moved into a new set with a single memcpy; no other comparisons are made. Ownership of the elements
+ * passes to the new sets, so set is left empty rather than having its cleanup function called. If set owns slabs, the
+ * larger half takes them over: in an indirect set the records of the smaller half are copied into a pool of its own,
+ * and in a power set the subsets of the smaller half are moved out of the slabs.
+ */
+void cset_split(CSet* set, void* pivot, CSet** left, CSet** right) {
+    assert(!immutable(set));
+    Probe probe;
+    make_probe(set, pivot, &probe);
+    int index = lower_bound(set, &probe);
+    int n_right = set->n_elements - index;
+
+    *left = create_like(set, index);
+    *right = create_like(set, n_right);
+    memcpy(nth(*left, 0), nth(set, 0), index * set->slotsz);
+    memcpy(nth(*right, 0), nth(set, index), n_right * set->slotsz);
+    (*left)->n_elements = index;
+    (*right)->n_elements = n_right;
+    (*left)->hash_valid = false;
+    (*right)->hash_valid = false;
+    if(set->extras != NULL && set->extras->n_slabs > 0) {
+        CSet* larger = index >= n_right ? *left : *right;
+        CSet* smaller = larger == *left ? *right : *left;
+        adopt_slabs(larger, set, 0);
+        larger->extras->slab_trivial = set->extras->slab_trivial;
+        for(int i = 0; i < smaller->n_elements; i++) {
+            void* ith = nth(smaller, i);
+            if(set->indirect) {
+                void* original = *(void **)ith;
+                copy_record(smaller, ith);
+                record_free(larger, original);
+            } else if((*(CSet **)ith)->slab_owner == set) {
+                *(CSet **)ith = detach_from_slab(*(CSet **)ith);
+            }
+        }
+    }
+
+    set->n_elements = 0;
+    reset_hash(set);
+}
+
+/* Function: cset_concat
+ * ---------------------
+ * Appends all of set2's elements to the end of set1 with a single memcpy. This is only valid when set1's greatest
+ * element is less than set2's least element, which takes a single comparison to verify. If it doesn't hold, nothing
+ * is moved and false is returned. On success, set2 is left empty since its elements now belong to set1, along with
+ * any slabs they use (set2's record pool, or the slab of a power set's subsets).
+ */
+bool cset_concat(CSet* set1, CSet* set2) {
+    assert(set1->elemsz == set2->elemsz && set1->slotsz == set2->slotsz && set1->indirect == set2->indirect);
+    assert(!immutable(set1) && !immutable(set2));
+    if(set1 == set2) return set1->n_elements == 0;
+    if(set2->n_elements == 0) return true;
+    if(set1->n_elements > 0 && compare_elements(set1, nth(set1, set1->n_elements - 1), nth(set2, 0)) >= 0) return false;
+
+    own_buffer(set1);
+    ensure_capacity(set1, set1->n_elements + set2->n_elements);
+    int first = set1->n_elements;
+    memcpy(nth(set1, first), nth(set2, 0), set2->n_elements * set2->slotsz);
+    set1->n_elements += set2->n_elements;
+    adopt_slabs(set1, set2, first);
+    if(set1->extras != NULL) set1->extras->slab_trivial = false;
+    if(set1->hash_valid && set2->hash_valid) set1->hash += set2->hash;
+    else set1->hash_valid = false;
+    set2->n_elements = 0;
+    reset_hash(set2);
+    return true;
+}
+
+/* Function: cset_removeIf
+ * ------------------------
+ * Compacts the elements array in place: kept elements are copied down over removed ones, so each element is moved
+ * at most once and the relative order (and therefore sortedness) is preserved without any comparisons.
+ */
+int cset_removeIf(CSet* set, PredicateFn pred, void* ctx) {
+    assert(!immutable(set));
+    own_buffer(set);
+    int kept = 0;
+    for(int i = 0; i < set->n_elements; i++) {
+        void* ith = nth(set, i);
+        if(pred(elem_of(set, ith), ctx)) {
+            if(set->hash_valid) set->hash -= element_hash(set, ith);
+            if(set->cleanup_fn != NULL) set->cleanup_fn(elem_of(set, ith));
+            if(set->indirect) record_free(set, *(void **)ith);
+        } else {
+            if(kept != i) memcpy(nth(set, kept), ith, set->slotsz);
+            kept++;
+        }
+    }
+    int removed = set->n_elements - kept;
+    set->n_elements = kept;
+    maybe_shrink(set);
+    return removed;
+}
+
+/* Function: cset_filter
+ * ---------------------
+ * Calls pred once per element, marking the matches in a bitmap, so that the new set can be allocated at exactly the
+ * right size before the marked elements are copied across in order. Since a subsequence of a sorted array is sorted,
+ * no comparisons are needed.
+ */
+CSet* cset_filter(CSet* set, PredicateFn pred, void* ctx) {
+    uint64_t* matches = calloc(set->n_elements / 64 + 1, sizeof(uint64_t));
+    assert(matches != NULL);
+    int count = 0;
+    for(int i = 0; i < set->n_elements; i++) {
+        if(pred(elem_at(set, i), ctx)) {
+            matches[i / 64] |= (uint64_t)1 << (i % 64);
+            count++;
+        }
+    }
+
+    CSet* filtered = create_like(set, count);
+    for(int i = 0; i < set->n_elements; i++) {
+        if(!(matches[i / 64] >> (i % 64) & 1)) continue;
+        memcpy(nth(filtered, filtered->n_elements), nth(set, i), set->slotsz);
+        if(set->indirect) copy_record(filtered, nth(filtered, filtered->n_elements));
+        (filtered->n_elements)++;
+    }
+    free(matches);
+    filtered->hash_valid = false;
+    return filtered;
+}
+
 /* Function: cset_powerSet
  * -----------------------
  * Returns a set containing all the subsets of the passed set. The returned set will be a new set
- * containing elements of type CSet*. Generates all subsets of a given set by using a bit vector to
- * represent which elements to choose for a given subset. Performs this operation for every bit vector
- * from 1 to the size of the set.
+ * containing elements of type CSet*. cset_compare orders sets first by size and then lexicographically
+ * by their (ordered) elements, so the subsets are generated directly in that order and appended: for
+ * each size k from 0 to n, every combination of k indices is visited in lexicographic order. Since the
+ * passed set is sorted, lexicographic order of indices is lexicographic order of elements. No comparator
+ * is called and nothing is shifted, so construction is a single linear pass over the output.
  *
- * For example, a bit vector of 0000 0101 would correspond to choosing the elements at indices 0 and 2, and
- * a bit vector of 0001 0110 would correspond to choosing elements 1, 2, and 4. This algorithm insures that all
- * possible subsets are generated. Using the popcount of the bit vector as the size of the subset perfectly
- * sizes the subset's initial capacity. The empty set is optimized out of the loop b/c a capacity hint of 0
- * would trigger the default capacity, and we want to minimize its size to 1.
+ * For example, for n = 4 and k = 2 the index combinations are visited as {0, 1}, {0, 2}, {0, 3}, {1, 2},
+ * {1, 3}, {2, 3}. Each subset's capacity is exactly k; the empty set gets a capacity of 1.
+ *
+ * All of the subsets live in one slab owned by the power set: 2^n CSet headers in power set order, followed
+ * by their elements arrays in the same order. Every element is chosen in half of the subsets, so the
+ * elements take n * 2^(n - 1) slots, plus one for the empty set. Creation is a single allocation, iteration
+ * walks memory sequentially, and deleting the power set frees the slab in one call.
  */ 
 CSet* cset_powerSet(CSet* set) {
     //Uses 2^n where n is the size of the set to perfectly size the elements array of the power set.
-    int set_size = set->n_elements, pset_size = 1 << set_size;
-    CSet* power_set = cset_create(sizeof(CSet*), pset_size, cset_compare, cset_cleanup, cset_genericToString);
-    
-    //Adds the empty set to the power set. Uses 1 as lowest capacity_hint since 0 triggers a default.
-    CSet* empty = cset_create(set->elemsz, 1, set->cmp_fn, set->cleanup_fn, set->toString_fn);
-    cset_add(power_set, &empty);
-
-    //Uses a bit vector to exhaust every possible combination of elements to generate all subsets of the set.
-    for(unsigned int bit_vector = 1; bit_vector < pset_size; bit_vector++) {
-        //__builtin_popcount gives the number of active bits in an unsigned int.
-        CSet* subset = cset_create(set->elemsz, __builtin_popcount(bit_vector), set->cmp_fn, set->cleanup_fn, set->toString_fn);
-        for(int i = 0; i < set_size; i++) {
-            if((bit_vector >> i) & 1) cset_add(subset, nth(set, i));
+    int set_size = set->n_elements;
+    assert(set_size < 31 && !set->indirect);
+    int pset_size = 1 << set_size;
+    CSet* power_set = cset_createWithAllocator(sizeof(CSet*), pset_size, cset_compare, cset_cleanup,
+                                               cset_genericToString, allocator_of(set));
+
+    size_t elem_slots = ((size_t)set_size << set_size) / 2 + 1;
+    CSet* header = alloc_slab(power_set, pset_size * sizeof(CSet) + elem_slots * set->slotsz);
+    char* elements = (char *)(header + pset_size);
+
+    int combo[32];
+    for(int k = 0; k <= set_size; k++) {
+        for(int i = 0; i < k; i++) combo[i] = i;
+        while(true) {
+            init_slab_subset(header, elements, k == 0 ? 1 : k, set, power_set);
+            for(int i = 0; i < k; i++) {
+                memcpy(nth(header, i), nth(set, combo[i]), set->slotsz);
+            }
+            header->n_elements = k;
+            elements += header->capacity * set->slotsz;
+            CSet* subset = header++;
+            insert(power_set, &subset, NULL, power_set->n_elements);
+
+            //Advances to the next combination: bumps the rightmost index that has room, then packs the rest after it.
+            int i = k - 1;
+            while(i >= 0 && combo[i] == set_size - k + i) i--;
+            if(i < 0) break;
+            combo[i]++;
+            for(int j = i + 1; j < k; j++) combo[j] = combo[j - 1] + 1;
+        }
+    }
+
+    //Deleting the power set can skip the subsets entirely if their elements need no cleanup.
+    power_set->extras->slab_trivial = set->cleanup_fn == NULL;
+    if(hashable(set)) power_set->hash_fn = cset_genericHash;
+    return power_set;
+}
+
+/* Type Definition: PowerSetWorker
+ * -------------------------------
+ * The state of one thread of cset_powerSetParallel: the range of bit vectors it builds subsets for, and the slab it
+ * builds them in. threaded is false if no thread could be started for the worker, which then ran on the calling
+ * thread.
+ */
+typedef struct {
+    CSet* base;
+    CSet* power_set;
+    uint64_t (*binomials)[32];
+    unsigned int first;
+    unsigned int last;
+    void* slab;
+    bool threaded;
+} PowerSetWorker;
+
+/* Function: power_set_rank
+ * ------------------------
+ * Returns the position of the subset with the given bit vector in the order used by cset_compare: first by size,
+ * then lexicographically by elements. offsets[k] is the number of subsets with fewer than k elements. Within a size
+ * class, the lexicographic rank of the combination c_0 < c_1 < ... < c_(k-1) of n indices is
+ *      C(n, k) - 1 - sum over i of C(n - 1 - c_i, k - i).
+ */
+static unsigned int power_set_rank(unsigned int bit_vector, int n, uint64_t (*binomials)[32], uint64_t* offsets) {
+    int k = __builtin_popcount(bit_vector);
+    uint64_t rank = binomials[n][k] - 1;
+    int i = 0;
+    for(unsigned int bits = bit_vector; bits != 0; bits &= bits - 1, i++) {
+        rank -= binomials[n - 1 - __builtin_ctz(bits)][k - i];
+    }
+    return offsets[k] + rank;
+}
+
+/* Function: popcount_prefix
+ * -------------------------
+ * Returns the total number of set bits in the integers 0 through x - 1. Bit b is set in 2^b of every 2^(b+1)
+ * consecutive integers, so each bit is counted over the whole periods below x and then over the partial one.
+ */
+static uint64_t popcount_prefix(uint64_t x) {
+    uint64_t total = 0;
+    for(int b = 0; b < 63 && (x >> b) != 0; b++) {
+        uint64_t period = (uint64_t)1 << (b + 1);
+        uint64_t partial = x % period;
+        total += (x / period) << b;
+        if(partial > period / 2) total += partial - period / 2;
+    }
+    return total;
+}
+
+/* Function: power_set_worker
+ * --------------------------
+ * Thread routine for cset_powerSetParallel. Builds each subset in its range in the worker's slab, which was sized for
+ * every subset header and element in the range, by copying the chosen elements in order, and stores it directly at
+ * its final position in the power set. Positions are distinct, so no locking is needed.
+ */
+static void* power_set_worker(void* arg) {
+    PowerSetWorker* worker = arg;
+    CSet* base = worker->base;
+    int n = base->n_elements;
+    uint64_t offsets[32];
+    offsets[0] = 0;
+    for(int k = 1; k <= n; k++) offsets[k] = offsets[k - 1] + worker->binomials[n][k - 1];
+
+    size_t n_subsets = worker->last - worker->first;
+    CSet* header = worker->slab;
+    char* elements = (char *)(header + n_subsets);
+    for(unsigned int bit_vector = worker->first; bit_vector < worker->last; bit_vector++, header++) {
+        int k = __builtin_popcount(bit_vector);
+        init_slab_subset(header, elements, k == 0 ? 1 : k, base, worker->power_set);
+        for(unsigned int bits = bit_vector; bits != 0; bits &= bits - 1) {
+            memcpy(nth(header, header->n_elements), nth(base, __builtin_ctz(bits)), base->slotsz);
+            (header->n_elements)++;
         }
-        cset_add(power_set, &subset);
+        elements += header->capacity * base->slotsz;
+        CSet* subset = header;
+        memcpy(nth(worker->power_set, power_set_rank(bit_vector, n, worker->binomials, offsets)), &subset, sizeof(CSet*));
+    }
+    return NULL;
+}
+
+/* Function: cset_powerSetParallel
+ * -------------------------------
+ * Builds the same power set as cset_powerSet using n_threads threads. The bit vector range is split into contiguous
+ * chunks, one per thread. Since each subset's position in the sorted power set can be computed directly from its bit
+ * vector (see power_set_rank), the threads write straight into the power set's array and no comparisons or serial
+ * insertions are needed. Each thread's slab is allocated up front by the calling thread, so the set's allocator need
+ * not be thread-safe, and handed to the power set, which frees them when it is deleted. If the processor count is
+ * unavailable, one thread is used, and a chunk whose thread can't be started is built on the calling thread instead.
+ */
+CSet* cset_powerSetParallel(CSet* set, int n_threads) {
+    int n = set->n_elements;
+    assert(n < 31 && !set->indirect);
+    if(n_threads <= 0) n_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    //sysconf returns -1 if the count is unavailable.
+    if(n_threads < 1) n_threads = 1;
+    unsigned int pset_size = 1u << n;
+    if(n_threads > pset_size) n_threads = pset_size;
+
+    CSet* power_set = cset_createWithAllocator(sizeof(CSet*), pset_size, cset_compare, cset_cleanup,
+                                               cset_genericToString, allocator_of(set));
+    power_set->n_elements = pset_size;
+
+    //Pascal's triangle of binomial coefficients, shared read-only by the workers.
+    uint64_t binomials[32][32];
+    memset(binomials, 0, sizeof(binomials));
+    for(int i = 0; i <= n; i++) {
+        binomials[i][0] = 1;
+        for(int j = 1; j <= i; j++) binomials[i][j] = binomials[i - 1][j - 1] + binomials[i - 1][j];
+    }
+
+    PowerSetWorker* workers = malloc(n_threads * sizeof(PowerSetWorker));
+    pthread_t* threads = malloc(n_threads * sizeof(pthread_t));
+    assert(workers != NULL && threads != NULL);
+    for(int i = 0; i < n_threads; i++) {
+        workers[i].base = set;
+        workers[i].power_set = power_set;
+        workers[i].binomials = binomials;
+        workers[i].first = (uint64_t)pset_size * i / n_threads;
+        workers[i].last = (uint64_t)pset_size * (i + 1) / n_threads;
+        //Each subset reserves at least one slot so that even the empty set has a valid elements array.
+        size_t slab_slots = popcount_prefix(workers[i].last) - popcount_prefix(workers[i].first) + (i == 0);
+        size_t n_subsets = workers[i].last - workers[i].first;
+        workers[i].slab = alloc_slab(power_set, n_subsets * sizeof(CSet) + slab_slots * set->slotsz);
+        workers[i].threaded = pthread_create(&threads[i], NULL, power_set_worker, &workers[i]) == 0;
+        if(!workers[i].threaded) power_set_worker(&workers[i]);
+    }
+
+    for(int i = 0; i < n_threads; i++) {
+        if(workers[i].threaded) pthread_join(threads[i], NULL);
     }
+    power_set->extras->slab_trivial = set->cleanup_fn == NULL;
+    if(hashable(set)) power_set->hash_fn = cset_genericHash;
 
+    free(workers);
+    free(threads);
     return power_set;
 }
 
+/* Function: subset_iterator_create
+ * --------------------------------
+ * Allocates an iterator of the given kind over set with a reusable subset of the given capacity. The subset doesn't
+ * own its elements, so its cleanup function is removed. Subsets of indirect sets would share records with the base
+ * set, so those aren't supported.
+ */
+static CSetSubsetIterator* subset_iterator_create(SubsetIteratorKind kind, CSet* set, int capacity) {
+    assert(!set->indirect);
+    CSetSubsetIterator* it = malloc(sizeof(CSetSubsetIterator));
+    assert(it != NULL);
+    it->kind = kind;
+    it->base = set;
+    it->subset = create_like(set, capacity);
+    it->subset->cleanup_fn = NULL;
+    it->started = false;
+    it->finished = false;
+    it->words = 0;
+    it->chosen = NULL;
+    it->position = NULL;
+    it->last = NULL;
+    it->k = 0;
+    it->combo = NULL;
+    return it;
+}
+
+/* Function: cset_powerSetCursorWords
+ * ----------------------------------
+ * A cursor must be able to hold 2^n, which takes n + 1 bits.
+ */
+int cset_powerSetCursorWords(CSet* set) {
+    return set->n_elements / 64 + 1;
+}
+
+/* Function: words_compare
+ * -----------------------
+ * Compares two multiword integers of the given length, stored least significant word first.
+ */
+static int words_compare(const uint64_t* a, const uint64_t* b, int words) {
+    for(int w = words - 1; w >= 0; w--) {
+        if(a[w] != b[w]) return a[w] < b[w] ? -1 : 1;
+    }
+    return 0;
+}
+
+/* Function: cset_powerSetIteratorRange
+ * ------------------------------------
+ * Creates an iterator over the Gray code positions first through last - 1. The three multiword integers the iterator
+ * needs share one allocation. first defaults to 0, and last defaults to 2^n, the number of subsets. A position past
+ * 2^n would make the Gray code step select elements beyond the end of the base set, so the range is checked.
+ */
+CSetSubsetIterator* cset_powerSetIteratorRange(CSet* set, const uint64_t* first, const uint64_t* last) {
+    CSetSubsetIterator* it = subset_iterator_create(POWER_SET_ITERATOR, set, set->n_elements);
+    int words = cset_powerSetCursorWords(set);
+    it->words = words;
+    it->chosen = calloc(3 * words, sizeof(uint64_t));
+    assert(it->chosen != NULL);
+    it->position = it->chosen + words;
+    it->last = it->position + words;
+    //chosen isn't filled in until the first subset is produced, so it holds 2^n in the meantime.
+    uint64_t* end = it->chosen;
+    end[set->n_elements / 64] = (uint64_t)1 << (set->n_elements % 64);
+    if(first != NULL) memcpy(it->position, first, words * sizeof(uint64_t));
+    memcpy(it->last, last != NULL ? last : end, words * sizeof(uint64_t));
+    assert(words_compare(it->position, it->last, words) <= 0 && words_compare(it->last, end, words) <= 0);
+    return it;
+}
+
+/* Function: cset_powerSetIterator
+ * -------------------------------
+ * Creates an iterator over all subsets of the given set in binary reflected Gray code order: the subset at position p
+ * is the one whose bit vector is p ^ (p >> 1). Consecutive Gray codes differ in exactly one bit (the lowest set bit
+ * of p), so each step adds or removes a single element from the reusable subset.
+ */
+CSetSubsetIterator* cset_powerSetIterator(CSet* set) {
+    return cset_powerSetIteratorRange(set, NULL, NULL);
+}
+
+/* Function: cset_subsetIteratorCursor
+ * -----------------------------------
+ * Copies the position of the next subset to be produced into cursor.
+ */
+void cset_subsetIteratorCursor(CSetSubsetIterator* it, uint64_t* cursor) {
+    assert(it->kind == POWER_SET_ITERATOR);
+    memcpy(cursor, it->position, it->words * sizeof(uint64_t));
+}
+
+/* Function: cset_combinationsIterator
+ * -----------------------------------
+ * Creates an iterator over the k-element subsets of the given set in colex order. The reusable subset always holds
+ * exactly k elements. If k is out of range there are no combinations, so the iterator starts out finished.
+ */
+CSetSubsetIterator* cset_combinationsIterator(CSet* set, int k) {
+    CSetSubsetIterator* it = subset_iterator_create(COMBINATIONS_ITERATOR, set, k < 0 ? 0 : k);
+    it->k = k;
+    if(k < 0 || k > set->n_elements) {
+        it->finished = true;
+        return it;
+    }
+    it->combo = malloc((k + 1) * sizeof(int));
+    assert(it->combo != NULL);
+    for(int i = 0; i < k; i++) {
+        it->combo[i] = i;
+        memcpy(nth(it->subset, i), nth(set, i), set->slotsz);
+    }
+    it->combo[k] = set->n_elements;
+    it->subset->n_elements = k;
+    it->subset->hash_valid = false;
+    return it;
+}
+
+/* Function: power_set_start
+ * -------------------------
+ * Fills the reusable subset with the subset at the iterator's current position, whose bit vector is the Gray code
+ * position ^ (position >> 1). Elements are appended in base order, so no comparisons are needed.
+ */
+static void power_set_start(CSetSubsetIterator* it) {
+    own_buffer(it->subset);
+    for(int w = 0; w < it->words; w++) {
+        uint64_t high = w + 1 < it->words ? it->position[w + 1] : 0;
+        it->chosen[w] = it->position[w] ^ ((it->position[w] >> 1) | (high << 63));
+    }
+    for(int i = 0; i < it->base->n_elements; i++) {
+        if((it->chosen[i / 64] >> (i % 64)) & 1) {
+            memcpy(nth(it->subset, it->subset->n_elements), nth(it->base, i), it->base->slotsz);
+            (it->subset->n_elements)++;
+        }
+    }
+    it->subset->hash_valid = false;
+}
+
+/* Function: power_set_next
+ * ------------------------
+ * Advances a power set iterator. Moving to position p flips the element at the lowest set bit of p in or out of the
+ * subset. The element's index in the subset is the number of chosen elements below it in the base set, so no
+ * comparisons are made. Toggling element i costs at most i element moves (insert and cset_removeRange shift the
+ * shorter side), and element i toggles once every 2^(i+1) steps, so the amortized cost per subset is O(1).
+ */
+static CSet* power_set_next(CSetSubsetIterator* it) {
+    if(words_compare(it->position, it->last, it->words) >= 0) {
+        it->finished = true;
+        return NULL;
+    }
+    if(!it->started) {
+        power_set_start(it);
+        it->started = true;
+    } else {
+        int w = 0;
+        while(it->position[w] == 0) w++;
+        int bit = w * 64 + __builtin_ctzll(it->position[w]);
+        uint64_t mask = (uint64_t)1 << (bit % 64);
+        int index = __builtin_popcountll(it->chosen[w] & (mask - 1));
+        for(int i = 0; i < w; i++) index += __builtin_popcountll(it->chosen[i]);
+        if(it->chosen[w] & mask) {
+            cset_removeRange(it->subset, index, index + 1);
+        } else {
+            void* elem = nth(it->base, bit);
+            insert(it->subset, elem, key_of(it->base, elem), index);
+        }
+        it->chosen[w] ^= mask;
+    }
+    //Increments the multiword position, carrying into higher words as needed.
+    for(int w = 0; w < it->words && ++(it->position[w]) == 0; w++);
+    return it->subset;
+}
+
+/* Function: combinations_next
+ * ---------------------------
+ * Advances a combinations iterator to the next combination in colex order: finds the lowest index j whose entry can be
+ * incremented without colliding with the entry above it, increments it, and resets every entry below j to its minimum.
+ * Only the entries 0 through j change, and only those slots of the subset are rewritten. The changed prefix has
+ * constant length on average, and its elements are copied straight from the base set in order.
+ */
+static CSet* combinations_next(CSetSubsetIterator* it) {
+    if(it->finished) return NULL;
+    if(!it->started) {
+        it->started = true;
+        return it->subset;
+    }
+    int* combo = it->combo;
+    int j = 0;
+    while(j < it->k && combo[j] + 1 == combo[j + 1]) j++;
+    if(j == it->k) {
+        it->finished = true;
+        return NULL;
+    }
+    combo[j]++;
+    own_buffer(it->subset);
+    memcpy(nth(it->subset, j), nth(it->base, combo[j]), it->base->slotsz);
+    for(int i = 0; i < j; i++) {
+        combo[i] = i;
+        memcpy(nth(it->subset, i), nth(it->base, i), it->base->slotsz);
+    }
+    it->subset->hash_valid = false;
+    return it->subset;
+}
+
+/* Function: cset_subsetIteratorNext
+ * ---------------------------------
+ * Advances the iterator according to its kind and returns the updated subset, or NULL once the subsets are exhausted.
+ */
+CSet* cset_subsetIteratorNext(CSetSubsetIterator* it) {
+    if(it->kind == POWER_SET_ITERATOR) return power_set_next(it);
+    return combinations_next(it);
+}
+
+/* Function: cset_subsetIteratorDelete
+ * -----------------------------------
+ * Frees the iterator and its reusable subset. The base set is not affected.
+ */
+void cset_subsetIteratorDelete(CSetSubsetIterator* it) {
+    cset_delete(it->subset);
+    free(it->chosen);
+    free(it->combo);
+    free(it);
+}
+
+/* Function: cset_powerSetForEach
+ * ------------------------------
+ * Callback form of cset_powerSetIteratorRange. Drives a range iterator and passes each subset to visit. Whether the
+ * range is completed or visit stops it early, the iterator's cursor is copied back to cursor so the caller can resume.
+ */
+bool cset_powerSetForEach(CSet* set, uint64_t* cursor, const uint64_t* last, SubsetVisitFn visit, void* ctx) {
+    CSetSubsetIterator* it = cset_powerSetIteratorRange(set, cursor, last);
+    bool completed = true;
+    for(CSet* subset = power_set_next(it); subset != NULL; subset = power_set_next(it)) {
+        if(!visit(subset, ctx)) {
+            completed = false;
+            break;
+        }
+    }
+    if(cursor != NULL) cset_subsetIteratorCursor(it, cursor);
+    cset_subsetIteratorDelete(it);
+    return completed;
+}
+
+/* Function: cset_combinations
+ * ---------------------------
+ * Callback form of cset_combinationsIterator. Drives the iterator and passes each combination to visit, stopping early
+ * if visit returns false.
+ */
+bool cset_combinations(CSet* set, int k, SubsetVisitFn visit, void* ctx) {
+    CSetSubsetIterator* it = cset_combinationsIterator(set, k);
+    bool completed = true;
+    for(CSet* subset = combinations_next(it); subset != NULL; subset = combinations_next(it)) {
+        if(!visit(subset, ctx)) {
+            completed = false;
+            break;
+        }
+    }
+    cset_subsetIteratorDelete(it);
+    return completed;
+}
+
+/* Function: family_mask
+ * ---------------------
+ * Returns the bitmask of the ith subset in the family.
+ */
+static inline uint64_t* family_mask(CSetFamily* family, int i) {
+    return family->masks + (size_t)i * family->words_per_mask;
+}
+
+/* Function: mask_next
+ * -------------------
+ * Returns the index of the first set bit in mask at or after bit from, or -1 if there is none.
+ */
+static int mask_next(const uint64_t* mask, int words, int from) {
+    int word = from / 64;
+    if(word >= words) return -1;
+    uint64_t bits = mask[word] & (~(uint64_t)0 << (from % 64));
+    while(bits == 0) {
+        if(++word == words) return -1;
+        bits = mask[word];
+    }
+    return word * 64 + __builtin_ctzll(bits);
+}
+
+/* Function: cset_familyCreate
+ * ---------------------------
+ * Allocates an empty family over base. Each mask needs one bit per element of base, rounded up to whole words.
+ */
+CSetFamily* cset_familyCreate(CSet* base, size_t capacity_hint) {
+    CSetFamily* family = malloc(sizeof(CSetFamily));
+    assert(family != NULL);
+    family->base = base;
+    family->words_per_mask = base->n_elements == 0 ? 1 : (base->n_elements + 63) / 64;
+    family->capacity = capacity_hint == 0 ? DEFAULT_CAPACITY : capacity_hint;
+    family->masks = malloc(family->capacity * family->words_per_mask * sizeof(uint64_t));
+    assert(family->masks != NULL);
+    family->n_subsets = 0;
+    return family;
+}
+
+/* Function: cset_familyDelete
+ * ---------------------------
+ * Frees the family's masks and the family itself. The base set is owned by the client and is not deleted.
+ */
+void cset_familyDelete(CSetFamily* family) {
+    free(family->masks);
+    free(family);
+}
+
+/* Function: family_append
+ * -----------------------
+ * Appends an all-zero mask to the family, growing the masks array by the resizing factor if needed, and returns it.
+ */
+static uint64_t* family_append(CSetFamily* family) {
+    if(family->n_subsets == family->capacity) {
+        family->capacity *= RESIZE_FACTOR;
+        family->masks = realloc(family->masks, family->capacity * family->words_per_mask * sizeof(uint64_t));
+        assert(family->masks != NULL);
+    }
+    uint64_t* mask = family_mask(family, family->n_subsets);
+    memset(mask, 0, family->words_per_mask * sizeof(uint64_t));
+    (family->n_subsets)++;
+    return mask;
+}
+
+/* Function: cset_familyAdd
+ * ------------------------
+ * Converts subset to a bitmask by locating each of its elements in the base set with a binary search. If any element
+ * is missing from the base set, the partially built mask is discarded and false is returned.
+ */
+bool cset_familyAdd(CSetFamily* family, CSet* subset) {
+    CSet* base = family->base;
+    uint64_t* mask = family_append(family);
+    for(int i = 0; i < subset->n_elements; i++) {
+        Probe probe;
+        make_probe(base, elem_at(subset, i), &probe);
+        int index = index_of(base, &probe);
+        if(index < 0) {
+            (family->n_subsets)--;
+            return false;
+        }
+        mask[index / 64] |= (uint64_t)1 << (index % 64);
+    }
+    return true;
+}
+
+/* Function: cset_powerSetFamily
+ * -----------------------------
+ * Builds the power set of the given set as a family. The mask of the subset at position i is simply i, so the whole
+ * power set is one pass of writing integers with no element copies or per-subset allocations.
+ */
+CSetFamily* cset_powerSetFamily(CSet* set) {
+    assert(set->n_elements < 31);
+    int family_size = 1 << set->n_elements;
+    CSetFamily* family = cset_familyCreate(set, family_size);
+    for(int bit_vector = 0; bit_vector < family_size; bit_vector++) {
+        family->masks[bit_vector] = bit_vector;
+    }
+    family->n_subsets = family_size;
+    return family;
+}
+
+/* Function: cset_familySize
+ * -------------------------
+ * Returns the number of subsets in the family.
+ */
+int cset_familySize(CSetFamily* family) {
+    return family->n_subsets;
+}
+
+/* Function: cset_subsetSize
+ * -------------------------
+ * Returns the number of elements in the ith subset, which is the popcount of its mask.
+ */
+int cset_subsetSize(CSetFamily* family, int i) {
+    assert(0 <= i && i < family->n_subsets);
+    uint64_t* mask = family_mask(family, i);
+    int size = 0;
+    for(int w = 0; w < family->words_per_mask; w++) {
+        size += __builtin_popcountll(mask[w]);
+    }
+    return size;
+}
+
+/* Function: cset_subsetContains
+ * -----------------------------
+ * Finds elem in the base set with a binary search, then tests the corresponding bit of the ith subset's mask.
+ */
+bool cset_subsetContains(CSetFamily* family, int i, void* elem) {
+    assert(0 <= i && i < family->n_subsets);
+    CSet* base = family->base;
+    Probe probe;
+    make_probe(base, elem, &probe);
+    int index = index_of(base, &probe);
+    if(index < 0) return false;
+    return (family_mask(family, i)[index / 64] >> (index % 64)) & 1;
+}
+
+/* Functions: cset_subsetFirst, cset_subsetNext
+ * --------------------------------------------
+ * Iterators over the ith subset. Both return elements stored in the base set, found by scanning the subset's mask for
+ * the next set bit, so the elements come out in order.
+ */
+void* cset_subsetFirst(CSetFamily* family, int i) {
+    assert(0 <= i && i < family->n_subsets);
+    int index = mask_next(family_mask(family, i), family->words_per_mask, 0);
+    return index < 0 ? NULL : elem_at(family->base, index);
+}
+
+void* cset_subsetNext(CSetFamily* family, int i, void* prev) {
+    assert(0 <= i && i < family->n_subsets);
+    int index = mask_next(family_mask(family, i), family->words_per_mask, position_of(family->base, prev) + 1);
+    return index < 0 ? NULL : elem_at(family->base, index);
+}
+
+/* Function: cset_subsetToSet
+ * --------------------------
+ * Materializes the ith subset as a new CSet sized to exactly fit it. The elements are copied from the base set in
+ * index order, which is already sorted order, so no comparisons are needed.
+ */
+CSet* cset_subsetToSet(CSetFamily* family, int i) {
+    CSet* base = family->base;
+    CSet* subset = create_like(base, cset_subsetSize(family, i));
+    uint64_t* mask = family_mask(family, i);
+    for(int index = mask_next(mask, family->words_per_mask, 0); index >= 0;
+        index = mask_next(mask, family->words_per_mask, index + 1)) {
+        memcpy(nth(subset, subset->n_elements), nth(base, index), base->slotsz);
+        if(base->indirect) copy_record(subset, nth(subset, subset->n_elements));
+        (subset->n_elements)++;
+    }
+    subset->hash_valid = false;
+    return subset;
+}
+
 /* Function: cset_first
  * --------------------
  * Iterator. Returns the first element in the set (or NULL if empty).
  */ 
 void* cset_first(CSet* set) {
     if(cset_isEmpty(set)) return NULL;
-    return set->elements;
+    return elem_at(set, 0);
 }
 
 /* Function: cset_next
  * -------------------
  * Iterator. Given the previous element in the set, returns the next element. Returns NULL
- * to indicate that the end of the set has been reached.
+ * to indicate that the end of the set has been reached. In an indirect set, prev is found by binary search.
  */ 
 void* cset_next(CSet* set, void* prev) {
-    int index = get_index(set, prev);
+    int index = position_of(set, prev);
     if(index == set->n_elements - 1) return NULL;
-    return nth(set, index + 1);
+    return elem_at(set, index + 1);
 }
 
 /* Function: cset_toString
@@ -400,7 +2485,7 @@ char* cset_toString(CSet* set) {
     char set_str[SET_STR_MAX_LEN];
     set_str[0] = '{'; set_str[1] = '\0';
     for(int i = 0; i < set->n_elements; i++) {
-        char* elem_str = set->toString_fn(nth(set, i));
+        char* elem_str = set->toString_fn(elem_at(set, i));
         strcat(set_str, elem_str);
         if(i != set->n_elements - 1) strcat(set_str, ", ");
         free(elem_str);
@@ -426,7 +2511,7 @@ int cset_compare(const void* addr1, const void* addr2) {
     if(set1->elemsz != set2->elemsz) return set1->elemsz - set2->elemsz;
     //If we get to this point, compare the elements of each set using set1's comparison function.
     for(int i = 0; i < set1->n_elements; i++) {
-        int cmp_result = set1->cmp_fn(nth(set1, i), nth(set2, i));
+        int cmp_result = compare_elements(set1, nth(set1, i), nth(set2, i));
         if(cmp_result != 0) return cmp_result;
     }
     return 0;
@@ -450,3 +2535,58 @@ char* cset_genericToString(const void* addr) {
     return cset_toString(set);
 }
 
+/* Function: cset_genericHash
+ * ---------------------------
+ * Hash function for sets of sets. Since a set's hash doesn't depend on the order of its elements, equal sets hash
+ * equally however they were built.
+ */
+uint64_t cset_genericHash(const void* addr) {
+    CSet* set = *(CSet **)addr;
+    return cset_hash(set);
+}
+
+/* Function: cset_adoptBuffer
+ * --------------------------
+ * Wraps an existing buffer in a new set header. No elements are copied or compared.
+ */
+CSet* cset_adoptBuffer(void* buffer, size_t start, int n_elements, size_t capacity, size_t elemsz, CompareFn cmp_fn,
+                       CleanupElemFn cleanup_fn, ToStringFn toString_fn) {
+    assert(cmp_fn != NULL && buffer != NULL && capacity > 0 && start + n_elements <= capacity);
+    CSet* set = malloc(sizeof(CSet));
+    assert(set != NULL);
+    init_set(set, buffer, elemsz, capacity, cmp_fn, cleanup_fn, toString_fn);
+    set->start = start;
+    set->n_elements = n_elements;
+    return set;
+}
+
+/* Function: cset_releaseBuffer
+ * ----------------------------
+ * Detaches the set's buffer and frees the rest of the set. A buffer borrowed from a slab can't be handed out, so
+ * the elements are first moved into a buffer of their own, and so are any subsets living in the set's own slabs,
+ * which are freed with the set.
+ */
+void* cset_releaseBuffer(CSet* set, size_t elemsz, size_t* start, int* n_elements, size_t* capacity) {
+    assert(set->key_words == 0 && !set->indirect && (set->extras == NULL || set->extras->refcount == 1));
+    assert(!immutable(set) && allocator_of(set)->free_fn == default_free && set->elemsz == elemsz);
+    own_buffer(set);
+    if(set->extras != NULL && set->extras->n_slabs > 0) {
+        for(int i = 0; i < set->n_elements; i++) {
+            CSet** ith = nth(set, i);
+            if((*ith)->slab_owner == set) *ith = detach_from_slab(*ith);
+        }
+    }
+    //Relocating to a different capacity always allocates a fresh buffer.
+    if(!set->owns_elements) relocate(set, set->capacity + 1, 0);
+    void* buffer = set->elements;
+    *start = set->start;
+    *n_elements = set->n_elements;
+    *capacity = set->capacity;
+
+    set->elements = NULL;
+    set->n_elements = 0;
+    set->owns_elements = false;
+    set->cleanup_fn = NULL;
+    cset_delete(set);
+    return buffer;
+}
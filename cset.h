@@ -18,6 +18,11 @@
 
 #include <stdbool.h>    //for bool
 #include <stdlib.h>     //for size_t
+#include <stdint.h>     //for uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
     /* * * * * Type Definitions * * * * */
 
@@ -47,6 +52,76 @@ typedef void (*CleanupElemFn)(void* addr);
  */ 
 typedef char* (*ToStringFn)(const void* addr);
 
+/* Type Definition: PredicateFn
+ * ----------------------------
+ * Definition of a generic void* predicate function. Returns true if the value at address addr satisfies the
+ * predicate. The ctx pointer is passed through unchanged from the caller, allowing the predicate to use client data.
+ */ 
+typedef bool (*PredicateFn)(const void* addr, void* ctx);
+
+/* Type Definition: KeyEncodeFn
+ * ----------------------------
+ * Definition of a key encoding function for keyed sets (see cset_createKeyed). Writes a fixed-size binary key for the
+ * element at addr to key, which the set has zeroed. Keys must be order-preserving: comparing two keys byte by byte as
+ * unsigned values (as memcmp does) must order them the same way as their elements. cset_encodeUint64, cset_encodeInt64
+ * and cset_encodeDouble write individual fields in this form, so a composite key can be built by encoding each field
+ * in turn, most significant field first.
+ */ 
+typedef void (*KeyEncodeFn)(const void* addr, void* key);
+
+/* Type Definition: HashFn
+ * -----------------------
+ * Definition of a generic void* hash function. Returns a hash of the value at addr. Elements that compare equal must
+ * hash equally. The set mixes the result itself, so a simple hash (even the value itself) is good enough.
+ */ 
+typedef uint64_t (*HashFn)(const void* addr);
+
+/* Type Definition: CSetAllocator
+ * ------------------------------
+ * A source of memory for a set (see cset_createWithAllocator). alloc_fn returns a block of at least size bytes aligned
+ * for any type, or NULL on failure. realloc_fn resizes a block from alloc_fn, preserving its first old_size bytes.
+ * free_fn releases a block; it may do nothing, as for an arena that is released all at once. Each callback receives
+ * ctx, which the set passes through untouched.
+ */
+typedef struct {
+    void* (*alloc_fn)(void* ctx, size_t size);
+    void* (*realloc_fn)(void* ctx, void* addr, size_t old_size, size_t new_size);
+    void (*free_fn)(void* ctx, void* addr);
+    void* ctx;
+} CSetAllocator;
+
+/* Type Definition: CSetGrowthPolicy
+ * ---------------------------------
+ * How a set's elements array grows and shrinks (see cset_setGrowthPolicy). When the array is full it grows by
+ * growth_factor (which must be greater than 1), but by no more than max_growth slots if max_growth is nonzero. If
+ * shrink_threshold is nonzero, a removal that leaves fewer than shrink_threshold * capacity elements shrinks the array
+ * to growth_factor times the number of elements, so shrink_threshold * growth_factor must be less than 1 to keep
+ * the set from resizing back and forth. The default policy is {2, 0, 0}: double without limit and never shrink.
+ */
+typedef struct {
+    double growth_factor;
+    size_t max_growth;
+    double shrink_threshold;
+} CSetGrowthPolicy;
+
+/* Type Definition: CSetMemoryUsage
+ * --------------------------------
+ * A breakdown of the memory used by a set, in bytes (see cset_memoryUsage). header_bytes is the set's header, or 0 if
+ * the header lives in a slab owned by another set (as the subsets of a power set do), plus any bookkeeping the set has
+ * allocated beside it. allocated_bytes is the set's elements array at full capacity (0 if the array also lives in
+ * another set's slab), plus any slabs the set owns, such as a power set's subsets or an indirect set's records. An
+ * array shared with clones (see cset_clone) is split evenly between the sets sharing it, along with its reference
+ * count, so adding up the sets counts it once (give or take rounding). used_bytes is the part of the set's storage
+ * occupied by its current elements, split the same way. children_bytes is the total memory of the sets nested in the
+ * set. The total memory of the set is header_bytes + allocated_bytes + children_bytes.
+ */
+typedef struct {
+    size_t header_bytes;
+    size_t allocated_bytes;
+    size_t used_bytes;
+    size_t children_bytes;
+} CSetMemoryUsage;
+
 /* Incomplete Type Definition: CSet
  * --------------------------------
  * Defines the CSet type. The implementation remains opaque to the client for simplicity. A client should
@@ -54,6 +129,34 @@ typedef char* (*ToStringFn)(const void* addr);
  */
 typedef struct CSetImplementation CSet;
 
+/* Type Definition: SubsetVisitFn
+ * ------------------------------
+ * Definition of a callback invoked on each subset during a callback-based subset enumeration. The subset is owned by
+ * the enumeration and is only valid for the duration of the call. ctx is passed through unchanged from the caller.
+ * Returns true to continue the enumeration or false to stop it early.
+ */ 
+typedef bool (*SubsetVisitFn)(CSet* subset, void* ctx);
+
+/* Incomplete Type Definition: CSetSubsetIterator
+ * ----------------------------------------------
+ * Defines an iterator that enumerates subsets of a CSet one at a time without materializing them all. As with
+ * CSet, the implementation is opaque to the client.
+ */
+typedef struct CSetSubsetIteratorImplementation CSetSubsetIterator;
+
+/* Incomplete Type Definition: CSetFamily
+ * --------------------------------------
+ * Defines a family (list) of subsets of a single base CSet. Each subset is stored as a bitmask over the base set's
+ * elements rather than as a CSet of its own, so a family costs roughly n/8 bytes per subset for a base of n elements.
+ */
+typedef struct CSetFamilyImplementation CSetFamily;
+
+/* Incomplete Type Definition: CSetInternTable
+ * -------------------------------------------
+ * Defines a table of canonical (interned) sets, in which each distinct set content appears once. See cset_intern.
+ */
+typedef struct CSetInternTableImplementation CSetInternTable;
+
     /* * * * * Public Functions * * * * */
 
 /* Function: cset_create
@@ -70,24 +173,100 @@ typedef struct CSetImplementation CSet;
  */ 
 CSet* cset_create(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn, ToStringFn toString_fn);
 
+/* Function: cset_createWithAllocator
+ * ----------------------------------
+ * Like cset_create, but all of the set's memory (its header, elements array, and any slabs) comes from the given
+ * allocator. The set keeps a pointer to the allocator, which must therefore remain valid as long as the set or any
+ * set derived from it does. Sets derived from it, by cset_union, cset_intersect, cset_difference, cset_split,
+ * cset_filter, cset_powerSet and the like, use the same allocator, so a whole computation's sets can be backed by one
+ * arena. If the arena's free_fn does nothing, the sets can be abandoned instead of deleted when the arena is released,
+ * provided their elements need no cleanup. Passing NULL uses malloc, as cset_create does.
+ */
+CSet* cset_createWithAllocator(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                               ToStringFn toString_fn, const CSetAllocator* allocator);
+
+/* Function: cset_createIndirect
+ * -----------------------------
+ * Like cset_create, but for large elements: each element is copied into a pool owned by the set, and the sorted array
+ * holds only pointers to them. Insertions and removals then shift 8 bytes per element, and growing the array copies
+ * pointers, however large the elements are. Elements never move once added, so pointers returned by cset_find,
+ * cset_at, cset_first and cset_next stay valid until that element is removed, and can be handed out as long-lived
+ * references. Searches dereference a pointer per comparison; cset_createKeyedIndirect avoids that by storing keys.
+ * The restrictions of cset_createKeyedIndirect apply.
+ */
+CSet* cset_createIndirect(size_t elemsz, size_t capacity_hint, CompareFn cmp_fn, CleanupElemFn cleanup_fn,
+                          ToStringFn toString_fn);
+
+/* Function: cset_createKeyed
+ * --------------------------
+ * Creates a keyed set, which is ordered by normalized keys instead of by a comparator. key_fn encodes each element
+ * into a key of keysz bytes (at most 64) when it is added, and the key is stored alongside the element. Searches
+ * encode the element being looked for once and then compare keys as 64-bit integers, so no client function is
+ * called while searching; for keys of up to 8 bytes each search step is branchless. Otherwise a keyed set behaves
+ * like any other set, and sets derived from it (by cset_union, cset_powerSet and the like) are keyed too.
+ */
+CSet* cset_createKeyed(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn, CleanupElemFn cleanup_fn,
+                       ToStringFn toString_fn);
+
+/* Function: cset_createKeyedIndirect
+ * ----------------------------------
+ * Creates a keyed set for large elements. The sorted array holds only each element's key and a pointer to the
+ * element, which is copied into a pool owned by the set, so searches read nothing but keys and insertions and
+ * removals shift 16 or so bytes per element however large the elements are. Elements never move once added: pointers
+ * returned by cset_find, cset_at, cset_first and cset_next stay valid until that element is removed. Indirect sets
+ * can't be used with cset_powerSet, cset_powerSetParallel or the subset iterators. Arguments are as for
+ * cset_createKeyed.
+ */
+CSet* cset_createKeyedIndirect(size_t elemsz, size_t keysz, size_t capacity_hint, KeyEncodeFn key_fn,
+                               CleanupElemFn cleanup_fn, ToStringFn toString_fn);
+
+/* Function: cset_createStringSet
+ * ------------------------------
+ * Creates a set of C strings: its elements are char* pointers, ordered as strcmp orders the strings they point to.
+ * The first 8 bytes of each string are stored inline beside its pointer, so a search compares prefixes as integers
+ * and only dereferences the pointers (to call strcmp) when two strings share a prefix. The strings must not be
+ * modified while they are in the set. cleanup_fn and toString_fn are as for cset_create.
+ */
+CSet* cset_createStringSet(size_t capacity_hint, CleanupElemFn cleanup_fn, ToStringFn toString_fn);
+
+/* Functions: cset_encodeUint64, cset_encodeInt64, cset_encodeDouble
+ * -----------------------------------------------------------------
+ * Write value to the 8 bytes at key in order-preserving form, for use in a KeyEncodeFn. Each writes big-endian bytes;
+ * signed integers have their sign bit flipped, and doubles have their sign bit flipped if positive or all of their
+ * bits flipped if negative.
+ */
+void cset_encodeUint64(void* key, uint64_t value);
+void cset_encodeInt64(void* key, int64_t value);
+void cset_encodeDouble(void* key, double value);
+
 /* Function: cset_delete
  * ---------------------
  * Frees all heap-allocated memory associated with the given set and deletes the set itself. Calls the client's cleanup function
- * on each element in the set if that cleanup function is non-NULL.
+ * on each element in the set if that cleanup function is non-NULL. If the set has been retained (see cset_retain), this only
+ * releases one reference, and the set is deleted when its last reference is released.
  */ 
 void cset_delete(CSet* set);
 
 /* Function: cset_add
  * ------------------
  * Adds the element at address elem to the givenn set. The element itself is copied and stored in the CSet, rather than a pointer
- * to the element. 
+ * to the element. Elements added in ascending order are appended in O(1) time. Returns false if the element was already in the set.
  */ 
 bool cset_add(CSet* set, void* elem);
 
+/* Function: cset_addHint
+ * ----------------------
+ * Adds the element at address elem to the given set, as with cset_add, using hint_position as a guess at the index
+ * where the element belongs (for example, one past the index of the previously added element). The search proceeds
+ * outward from the hint, so the cost depends on how far off the hint is rather than on the size of the set. Any hint
+ * is valid; out-of-range hints are clamped. Returns false if the element was already in the set.
+ */
+bool cset_addHint(CSet* set, void* elem, int hint_position);
+
 /* Function: cset_clear
  * --------------------
  * Removes all elements from the CSet, freeing all heap-allocated memory associated with them. Equivalent to calling cset_remove
- * on every element, but vastly more efficient.
+ * on every element, but vastly more efficient. The capacity is kept unless the set's growth policy shrinks it.
  */ 
 void cset_clear(CSet* set);
 
@@ -98,6 +277,14 @@ void cset_clear(CSet* set);
  */ 
 bool cset_contains(CSet* set, void* elem);
 
+/* Function: cset_find
+ * -------------------
+ * Returns a pointer to the element of the set equal to elem, or NULL if there is none. Like cset_at, this gives access
+ * to the stored copy (for example, to the rest of a record keyed by some of its fields) without a second search. The
+ * pointer is invalidated when the set is modified.
+ */
+void* cset_find(CSet* set, void* elem);
+
 /* Function: cset_remove
  * ---------------------
  * Removes the element at address elem from the given set if it is contained in the set. Calls the client's cleanup function on
@@ -105,6 +292,32 @@ bool cset_contains(CSet* set, void* elem);
  */ 
 bool cset_remove(CSet* set, void* elem);
 
+/* Function: cset_removeRange
+ * --------------------------
+ * Removes the elements with indices i (inclusive) through j (exclusive) from the given set, where index 0 holds the
+ * least element. Calls the client's cleanup function on each removed element. Requires 0 <= i <= j <= cset_size(set).
+ */
+void cset_removeRange(CSet* set, int i, int j);
+
+/* Functions: cset_popFirst, cset_popLast
+ * --------------------------------------
+ * Removes the least (cset_popFirst) or greatest (cset_popLast) element from the given set in O(1) time. If out is
+ * non-NULL, the removed element is copied to address out and the client takes ownership of it, so the cleanup function
+ * is not called; if out is NULL, the element is cleaned up as in cset_remove. Returns false if the set is empty.
+ */
+bool cset_popFirst(CSet* set, void* out);
+bool cset_popLast(CSet* set, void* out);
+
+/* Functions: cset_at, cset_rank
+ * -----------------------------
+ * Positional access to the set's ordered elements. cset_at returns a pointer to the element with index i (the
+ * (i + 1)th least element), or NULL if i is out of range; it runs in O(1) time. cset_rank returns the number of
+ * elements in the set that are less than the element at address elem, which is that element's index if it is
+ * contained in the set; it runs in O(log n) time.
+ */
+void* cset_at(CSet* set, int i);
+int cset_rank(CSet* set, void* elem);
+
 /* Functions: cset_size, cset_cardinality
  * --------------------------------------
  * Returns the number of elements in the given set. The two functions are interchangable.
@@ -118,6 +331,34 @@ int cset_cardinality(CSet* set);
  */ 
 bool cset_isEmpty(CSet* set);
 
+/* Functions: cset_capacity, cset_reserve, cset_shrinkToFit
+ * --------------------------------------------------------
+ * Capacity management. cset_capacity returns the number of elements the set's array currently has room for.
+ * cset_reserve makes room for at least n elements, with enough free space around them that the set won't grow until
+ * it holds more than n. cset_shrinkToFit shrinks the array to exactly the set's size (or one slot if it is empty).
+ * The records of an indirect set never move, so only its array of pointers is resized; freed records are reused by
+ * later insertions.
+ */
+size_t cset_capacity(CSet* set);
+void cset_reserve(CSet* set, size_t n);
+void cset_shrinkToFit(CSet* set);
+
+/* Function: cset_setGrowthPolicy
+ * ------------------------------
+ * Sets the growth policy of the given set, or restores the default if policy is NULL. Sets derived from this one
+ * (by cset_union, cset_split and the like) inherit its policy.
+ */
+void cset_setGrowthPolicy(CSet* set, const CSetGrowthPolicy* policy);
+
+/* Function: cset_memoryUsage
+ * --------------------------
+ * Reports the memory used by the given set. If recursive is true and the set is a set of sets (one created with
+ * cset_compare), children_bytes totals the memory of each nested set, recursively; otherwise it is 0. A nested set
+ * that appears in several sets (see cset_retain and cset_intern) is counted each time it appears. Nothing is
+ * allocated, so this can be used to investigate a process that is short of memory.
+ */
+CSetMemoryUsage cset_memoryUsage(CSet* set, bool recursive);
+
 /* Function: cset_isSubsetOf
  * -------------------------
  * Returns true if set1 is a subset of set2, i.e. if set2 contains all of the elements
@@ -126,6 +367,71 @@ bool cset_isEmpty(CSet* set);
  */ 
 bool cset_isSubsetOf(CSet* set1, CSet* set2);
 
+/* Function: cset_setHashFn
+ * ------------------------
+ * Enables hashing of the given set's contents (see cset_hash), with hash_fn hashing individual elements. Sets derived
+ * from this one (by cset_union, cset_filter, cset_powerSet and the like) inherit hash_fn. Keyed sets created with
+ * cset_createKeyed hash their keys, so they need no hash function.
+ */
+void cset_setHashFn(CSet* set, HashFn hash_fn);
+
+/* Function: cset_hash
+ * -------------------
+ * Returns a hash of the set's contents that doesn't depend on the order in which elements were added: equal sets
+ * hash equally. The hash is kept up to date as single elements are added and removed, so it usually costs O(1); after
+ * bulk operations it is recomputed on the next call. The set must be hashable (see cset_setHashFn). As with its order,
+ * modifying an element in place (such as a nested set) while it is in the set leaves the set's hash stale.
+ */
+uint64_t cset_hash(CSet* set);
+
+/* Function: cset_equals
+ * ---------------------
+ * Returns true if set1 and set2 contain the same elements, using set1's comparator. If both sets are hashable and their
+ * hashes differ, returns false without comparing any elements.
+ */
+bool cset_equals(CSet* set1, CSet* set2);
+
+/* Function: cset_retain
+ * ---------------------
+ * Adds a reference to the given set and returns it, so that it can be stored in another place (such as a second set of
+ * sets) and deleted once from each. The set must not live in a power set's slab.
+ */
+CSet* cset_retain(CSet* set);
+
+/* Function: cset_clone
+ * --------------------
+ * Returns a new set with the same elements as the given set, in O(1) time: the two sets share one elements array until
+ * either is modified, and the first modification copies it. This makes clones cheap snapshots, for example for a reader
+ * on another thread while the original goes on changing: the shared array is released safely by whichever set lets go
+ * of it last, though each set must still be used by one thread at a time. Like any copy of the elements, the clone is
+ * shallow: it doesn't own its elements, so it has no cleanup function, and memory that the elements point to must
+ * outlive its use through the clone. Subsets in a power set's slab and indirect sets are copied immediately. The clone
+ * must be deleted with cset_delete.
+ */
+CSet* cset_clone(CSet* set);
+
+/* Functions: cset_internTableCreate, cset_internTableDelete
+ * ---------------------------------------------------------
+ * Create and delete a table of interned sets. Deleting the table doesn't delete the sets in it; sets that are still
+ * referenced stay valid (and immutable), but are no longer canonical. Intern tables are not thread-safe.
+ */
+CSetInternTable* cset_internTableCreate(size_t capacity_hint);
+void cset_internTableDelete(CSetInternTable* table);
+
+/* Function: cset_intern
+ * ---------------------
+ * Returns the canonical set in table with the same contents as set, which must be hashable (see cset_setHashFn).
+ * Takes over the caller's reference to set: if an equal set is already interned, set is deleted and the canonical set
+ * gains a reference; otherwise set itself becomes canonical. Either way the caller releases the result with
+ * cset_delete (or cset_cleanup, when it is stored in a set of sets), and the interned set is removed from the table
+ * when its last reference is released.
+ *
+ * Interned sets are immutable, so equal contents can be shared, and two sets interned in the same table are equal
+ * exactly when they are the same pointer. Building sets of sets out of interned sets (and interning those in turn)
+ * makes nested comparisons, hashes and equality checks cheap.
+ */
+CSet* cset_intern(CSetInternTable* table, CSet* set);
+
 /* Function: cset_union
  * --------------------
  * Returns a new heap-allocated set containing all elements contained in either set1 or set2. The new
@@ -157,13 +463,143 @@ CSet* cset_difference(CSet* set1, CSet* set2);
  */ 
 CSet* cset_symmetricDifference(CSet* set1, CSet* set2);
 
+/* Function: cset_split
+ * ---------------------
+ * Splits the given set into two new heap-allocated sets: *left receives every element less than the element at
+ * address pivot, and *right receives the rest. Runs in O(log n) comparisons plus two copies. The elements are moved
+ * rather than copied, so set is left empty (but must still be deleted by the client).
+ */
+void cset_split(CSet* set, void* pivot, CSet** left, CSet** right);
+
+/* Function: cset_concat
+ * ---------------------
+ * Moves every element of set2 onto the end of set1, leaving set2 empty. Requires every element of set2 to be greater
+ * than every element of set1, which is checked with a single comparison; if this does not hold, neither set is changed
+ * and false is returned. Returns true otherwise. Both sets must store the same type.
+ */
+bool cset_concat(CSet* set1, CSet* set2);
+
+/* Function: cset_removeIf
+ * ------------------------
+ * Removes every element of the given set for which pred returns true, calling the client's cleanup function on each
+ * removed element. The remaining elements keep their order. Runs in a single pass over the set. Returns the number
+ * of elements removed.
+ */
+int cset_removeIf(CSet* set, PredicateFn pred, void* ctx);
+
+/* Function: cset_filter
+ * ---------------------
+ * Returns a new heap-allocated set containing the elements of the given set for which pred returns true. pred is
+ * called exactly once per element, in order, so it may keep state in ctx. The new set uses the same functions as the
+ * given set and is allocated at exactly the size it needs.
+ */
+CSet* cset_filter(CSet* set, PredicateFn pred, void* ctx);
+
 /* Function: cset_powerSet
  * -----------------------
  * Returns the power set of the given set, which is a set containing all subsets of the given set. The power
- * set is a new heap-allocated set of type set, initialized using the functions for CSets given below.
+ * set is a new heap-allocated set of type set, initialized using the functions for CSets given below. The given
+ * set must have fewer than 31 elements. The subsets are allocated together in one block owned by the power set,
+ * so they remain valid only as long as the power set does; deleting the power set frees them all at once.
  */ 
 CSet* cset_powerSet(CSet* set);
 
+/* Function: cset_powerSetParallel
+ * -------------------------------
+ * Returns the same power set as cset_powerSet, built using n_threads threads (or one per online processor if n_threads
+ * is 0 or negative). The given set must have fewer than 31 elements. The subsets are allocated in a few large blocks
+ * owned by the returned power set, so they remain valid only as long as it does; deleting the power set frees them.
+ */
+CSet* cset_powerSetParallel(CSet* set, int n_threads);
+
+/* Functions: cset_powerSetIterator, cset_subsetIteratorNext, cset_subsetIteratorDelete
+ * ------------------------------------------------------------------------------------
+ * A streaming alternative to cset_powerSet, usable for sets of any size. cset_powerSetIterator returns a heap-allocated
+ * iterator over every subset of the given set. Each call to cset_subsetIteratorNext returns the next subset, or NULL
+ * once all 2^n subsets have been produced; the first subset returned is the empty set.
+ *
+ * Subsets are produced in Gray code order, not in the order used by cset_powerSet. The returned CSet* is a single
+ * buffer owned by the iterator and updated in place, so it is only valid until the next call and must not be modified
+ * or deleted by the client; use cset_union with an empty set to keep a copy. Enumeration costs O(1) amortized work
+ * per subset and O(n) memory. The base set must not be modified while the iterator is in use. cset_subsetIteratorDelete
+ * frees the iterator.
+ */
+CSetSubsetIterator* cset_powerSetIterator(CSet* set);
+CSet* cset_subsetIteratorNext(CSetSubsetIterator* it);
+void cset_subsetIteratorDelete(CSetSubsetIterator* it);
+
+/* Functions: cset_powerSetCursorWords, cset_powerSetIteratorRange, cset_subsetIteratorCursor, cset_powerSetForEach
+ * ---------------------------------------------------------------------------------------------------------------
+ * Resumable, splittable power set enumeration. Positions in the Gray code order above are numbered 0 through 2^n - 1
+ * and are stored in cursors: arrays of cset_powerSetCursorWords(set) uint64_t words holding an unsigned integer, least
+ * significant word first. Cursors are plain integers, so they can be saved to disk, sent to another process, or
+ * divided up arithmetically to split an enumeration into ranges.
+ *
+ * cset_powerSetIteratorRange returns an iterator, used like the one above, over positions first (inclusive) through
+ * last (exclusive), which must satisfy first <= last <= 2^n. Passing NULL for first starts at position 0, and passing
+ * NULL for last runs to the end. cset_subsetIteratorCursor, given a power set iterator, writes into cursor the position
+ * of the subset it will return next; creating a range iterator starting from that cursor resumes the enumeration where
+ * it left off.
+ *
+ * cset_powerSetForEach calls visit on each subset from position *cursor (or 0 if cursor is NULL) up to last (or the end
+ * if last is NULL), passing ctx through; the same bounds apply. If cursor is non-NULL it is updated to the position
+ * after the last subset visited. Returns true if the range was completed, or false if visit returned false and stopped
+ * it early.
+ */
+int cset_powerSetCursorWords(CSet* set);
+CSetSubsetIterator* cset_powerSetIteratorRange(CSet* set, const uint64_t* first, const uint64_t* last);
+void cset_subsetIteratorCursor(CSetSubsetIterator* it, uint64_t* cursor);
+bool cset_powerSetForEach(CSet* set, uint64_t* cursor, const uint64_t* last, SubsetVisitFn visit, void* ctx);
+
+/* Functions: cset_combinationsIterator, cset_combinations
+ * -------------------------------------------------------
+ * Enumerate the k-element subsets of the given set in colex order (ordered by greatest element, then next greatest,
+ * and so on), without allocating anything per subset. cset_combinationsIterator returns a heap-allocated iterator used
+ * with cset_subsetIteratorNext and cset_subsetIteratorDelete as described above; the reused subset it returns has the
+ * same restrictions. If k is negative or greater than the size of the set, there are no k-element subsets.
+ *
+ * cset_combinations calls visit on each k-element subset in the same order, passing ctx through. Returns true if every
+ * subset was visited, or false if visit returned false and stopped the enumeration early.
+ */
+CSetSubsetIterator* cset_combinationsIterator(CSet* set, int k);
+bool cset_combinations(CSet* set, int k, SubsetVisitFn visit, void* ctx);
+
+/* Functions: cset_familyCreate, cset_familyDelete, cset_familyAdd, cset_familySize
+ * -------------------------------------------------------------------------------
+ * cset_familyCreate returns a new heap-allocated, empty family of subsets of base, with room for capacity_hint subsets
+ * (0 selects a default). The family refers to base rather than copying it, so base must outlive the family and must not
+ * be modified while the family is in use. cset_familyDelete frees the family but not base.
+ *
+ * cset_familyAdd appends subset (a CSet whose elements all appear in base) to the family and returns true, or returns
+ * false without changing the family if some element of subset is not in base. A family is a list: adding the same
+ * subset twice stores it twice. cset_familySize returns the number of subsets in the family.
+ */
+CSetFamily* cset_familyCreate(CSet* base, size_t capacity_hint);
+void cset_familyDelete(CSetFamily* family);
+bool cset_familyAdd(CSetFamily* family, CSet* subset);
+int cset_familySize(CSetFamily* family);
+
+/* Function: cset_powerSetFamily
+ * -----------------------------
+ * Returns a new heap-allocated family holding every subset of the given set (which must have fewer than 31 elements).
+ * The subset at index i contains the base set's jth element exactly when bit j of i is set, so index 0 is the empty set.
+ * This is a compact alternative to cset_powerSet: no element is copied and no CSet is allocated per subset.
+ */
+CSetFamily* cset_powerSetFamily(CSet* set);
+
+/* Functions: cset_subsetSize, cset_subsetContains, cset_subsetFirst, cset_subsetNext, cset_subsetToSet
+ * ----------------------------------------------------------------------------------------------------
+ * Views of the subset at index i of the given family, mirroring cset_size, cset_contains, cset_first, and cset_next.
+ * The iterators return pointers to elements stored in the base set, in order. cset_subsetToSet returns a new
+ * heap-allocated CSet containing the subset's elements, created with the base set's functions, for when a full CSet
+ * is needed.
+ */
+int cset_subsetSize(CSetFamily* family, int i);
+bool cset_subsetContains(CSetFamily* family, int i, void* elem);
+void* cset_subsetFirst(CSetFamily* family, int i);
+void* cset_subsetNext(CSetFamily* family, int i, void* prev);
+CSet* cset_subsetToSet(CSetFamily* family, int i);
+
 /* Functions: cset_first, cset_next
  * --------------------------------
  * These functions are iterators over the set. cset_first returns a pointer to the first (or "least" by
@@ -182,14 +618,38 @@ void* cset_next(CSet* set, void* prev);
  */ 
 char* cset_toString(CSet* set);
 
-/* Functions: cset_compare, cset_cleanup, cset_genericToString
- * -----------------------------------------------------------
- * Comparator, cleanup, and toString function for sets, provided to allow functionality for nested
+/* Functions: cset_compare, cset_cleanup, cset_genericToString, cset_genericHash
+ * ----------------------------------------------------------------------------
+ * Comparator, cleanup, toString, and hash function for sets, provided to allow functionality for nested
  * sets. If creating a set of type CSet*, use these functions to initialize the set. Conform
- * to the definitions of CompareFn, CleanupElemFn, and ToStringFn.
+ * to the definitions of CompareFn, CleanupElemFn, ToStringFn, and HashFn. cset_genericHash requires
+ * the nested sets to be hashable.
  */ 
 int cset_compare(const void* addr1, const void* addr2);
 void cset_cleanup(void* addr);
 char* cset_genericToString(const void* addr);
+uint64_t cset_genericHash(const void* addr);
+
+/* Functions: cset_adoptBuffer, cset_releaseBuffer
+ * -----------------------------------------------
+ * Transfer a set's storage in or out without copying, for interoperating with other containers that keep the same
+ * layout (such as the C++ wrapper in cset.hpp). The storage is a malloc-allocated buffer of capacity slots of elemsz
+ * bytes, of which the n_elements slots beginning at slot start hold the elements in sorted order without duplicates.
+ *
+ * cset_adoptBuffer returns a new heap-allocated set that takes ownership of buffer; it trusts the caller that the
+ * elements are sorted by cmp_fn and distinct. cset_releaseBuffer hands the given set's buffer to the caller, storing
+ * its layout in *start, *n_elements, and *capacity, and then frees the set without cleaning up its elements. elemsz
+ * must match the size the set was created with. The caller becomes responsible for freeing the buffer (and any memory
+ * the elements own); the subsets of a power set are first moved out of its slabs, so each can be deleted on its own.
+ * Keyed sets store keys in their buffers, so their buffers can't be released, and neither can the buffers of sets
+ * using a custom allocator.
+ */
+CSet* cset_adoptBuffer(void* buffer, size_t start, int n_elements, size_t capacity, size_t elemsz, CompareFn cmp_fn,
+                       CleanupElemFn cleanup_fn, ToStringFn toString_fn);
+void* cset_releaseBuffer(CSet* set, size_t elemsz, size_t* start, int* n_elements, size_t* capacity);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,340 @@
+/* Filename: cset.hpp
+ * ------------------
+ * Header-only C++17 wrapper around the CSet design. csetpp::cset<T, Compare, Alloc> keeps its elements in the same
+ * layout as a C CSet (a sorted array occupying a window of a larger buffer, with free space at both ends), and uses
+ * the same algorithms: binary search for lookups, shifting the shorter side for insertions and removals, an O(1)
+ * append when elements arrive in order, and O(1) removal from either end.
+ *
+ * Unlike the C interface, the comparator is a type, so every comparison is inlined, and the set manages its own
+ * memory: it is destroyed automatically, moves in O(1), and copies deeply. Storage comes from Alloc, which defaults
+ * to a malloc-based allocator. With that default, a cset can be converted to and from a C CSet* without copying any
+ * elements, via from_c and release_to_c.
+ *
+ * Elements must be trivially copyable, since (as in CSet) they are relocated with memmove.
+ */
+
+#ifndef _cset_hpp
+#define _cset_hpp
+
+#include "cset.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace csetpp {
+
+    /* * * * * Allocator * * * * */
+
+/* Class: malloc_allocator
+ * -----------------------
+ * A standard allocator backed by malloc and free. Buffers from this allocator can be handed to and taken from the C
+ * CSet functions, which free with free().
+ */
+template <class T>
+struct malloc_allocator {
+    using value_type = T;
+
+    malloc_allocator() noexcept = default;
+    template <class U> malloc_allocator(const malloc_allocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        void* p = std::malloc(n * sizeof(T));
+        if(p == nullptr) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        std::free(p);
+    }
+
+    template <class U> bool operator==(const malloc_allocator<U>&) const noexcept { return true; }
+    template <class U> bool operator!=(const malloc_allocator<U>&) const noexcept { return false; }
+};
+
+    /* * * * * Set * * * * */
+
+/* Class: cset
+ * -----------
+ * An ordered set of T, ordered by Compare (a strict weak ordering, as for std::set). Iterators are plain pointers into
+ * the sorted array, so they are invalidated by any insertion or removal, just like pointers returned by cset_first and
+ * cset_next.
+ */
+template <class T, class Compare = std::less<T>, class Alloc = malloc_allocator<T>>
+class cset {
+    static_assert(std::is_trivially_copyable_v<T>, "cset elements are relocated with memmove");
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using key_compare = Compare;
+    using allocator_type = Alloc;
+    using const_iterator = const T*;
+    using iterator = const_iterator;
+
+    static constexpr size_type default_capacity = 32;
+
+    explicit cset(const Compare& cmp = Compare(), const Alloc& alloc = Alloc()) : cmp_(cmp), alloc_(alloc) {}
+
+    cset(std::initializer_list<T> elems, const Compare& cmp = Compare(), const Alloc& alloc = Alloc())
+        : cmp_(cmp), alloc_(alloc) {
+        reserve(elems.size());
+        for(const T& elem : elems) insert(elem);
+    }
+
+    cset(const cset& other)
+        : cmp_(other.cmp_), alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)) {
+        if(other.size_ == 0) return;
+        buf_ = alloc_.allocate(other.size_);
+        cap_ = other.size_;
+        std::memcpy(buf_, other.data(), other.size_ * sizeof(T));
+        size_ = other.size_;
+    }
+
+    cset(cset&& other) noexcept
+        : buf_(other.buf_), start_(other.start_), size_(other.size_), cap_(other.cap_),
+          cmp_(std::move(other.cmp_)), alloc_(std::move(other.alloc_)) {
+        other.buf_ = nullptr;
+        other.start_ = other.size_ = other.cap_ = 0;
+    }
+
+    cset& operator=(cset other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    ~cset() {
+        if(buf_ != nullptr) alloc_.deallocate(buf_, cap_);
+    }
+
+    void swap(cset& other) noexcept {
+        using std::swap;
+        swap(buf_, other.buf_);
+        swap(start_, other.start_);
+        swap(size_, other.size_);
+        swap(cap_, other.cap_);
+        swap(cmp_, other.cmp_);
+        swap(alloc_, other.alloc_);
+    }
+
+        /* * * * * Interop with CSet * * * * */
+
+    /* Function: from_c
+     * ----------------
+     * Takes ownership of a C set's buffer and frees the set header; no elements are copied. The set must store
+     * elements of sizeof(T) bytes (which is asserted) ordered consistently with Compare. The C set's cleanup function
+     * is not carried over.
+     */
+    static cset from_c(CSet* set, const Compare& cmp = Compare()) {
+        static_assert(std::is_same_v<Alloc, malloc_allocator<T>>, "only malloc-backed sets share buffers with CSet");
+        cset result(cmp);
+        int n_elements;
+        void* buffer = cset_releaseBuffer(set, sizeof(T), &result.start_, &n_elements, &result.cap_);
+        result.buf_ = static_cast<T*>(buffer);
+        result.size_ = n_elements;
+        return result;
+    }
+
+    /* Function: release_to_c
+     * ----------------------
+     * Hands this set's buffer to a new C set and leaves this set empty; no elements are copied. The C set compares
+     * with a function that default-constructs Compare, so Compare must be stateless.
+     */
+    CSet* release_to_c(CleanupElemFn cleanup_fn = nullptr, ToStringFn toString_fn = nullptr) {
+        static_assert(std::is_same_v<Alloc, malloc_allocator<T>>, "only malloc-backed sets share buffers with CSet");
+        static_assert(std::is_empty_v<Compare> && std::is_default_constructible_v<Compare>,
+                      "CSet comparators can't carry state");
+        if(buf_ == nullptr) reserve(1);
+        CSet* set = cset_adoptBuffer(buf_, start_, static_cast<int>(size_), cap_, sizeof(T), &compare_fn,
+                                     cleanup_fn, toString_fn);
+        buf_ = nullptr;
+        start_ = size_ = cap_ = 0;
+        return set;
+    }
+
+    /* Function: compare_fn
+     * --------------------
+     * A CompareFn that orders elements by Compare, for use with the C interface.
+     */
+    static int compare_fn(const void* addr1, const void* addr2) {
+        const T& a = *static_cast<const T*>(addr1);
+        const T& b = *static_cast<const T*>(addr2);
+        Compare cmp;
+        return cmp(a, b) ? -1 : (cmp(b, a) ? 1 : 0);
+    }
+
+        /* * * * * Capacity * * * * */
+
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_type capacity() const noexcept { return cap_; }
+
+    /* Function: reserve
+     * -----------------
+     * Ensures the buffer has room for at least n elements.
+     */
+    void reserve(size_type n) {
+        if(n > cap_) relocate(n, 0);
+    }
+
+        /* * * * * Access * * * * */
+
+    const T* data() const noexcept { return buf_ + start_; }
+    const_iterator begin() const noexcept { return data(); }
+    const_iterator end() const noexcept { return data() + size_; }
+
+    const T& operator[](size_type i) const { return data()[i]; }
+
+    const T& at(size_type i) const {
+        if(i >= size_) throw std::out_of_range("csetpp::cset::at");
+        return data()[i];
+    }
+
+    const T& front() const { return data()[0]; }
+    const T& back() const { return data()[size_ - 1]; }
+
+    /* Function: lower_bound
+     * ---------------------
+     * Branchless binary search for the first element not less than elem; each step compiles to a conditional move.
+     */
+    const_iterator lower_bound(const T& elem) const {
+        return data() + lower_bound_in(elem, 0, size_);
+    }
+
+    size_type rank(const T& elem) const { return lower_bound_in(elem, 0, size_); }
+
+    const_iterator find(const T& elem) const {
+        const_iterator it = lower_bound(elem);
+        return it != end() && !cmp_(elem, *it) ? it : end();
+    }
+
+    bool contains(const T& elem) const { return find(elem) != end(); }
+
+        /* * * * * Modifiers * * * * */
+
+    /* Function: insert
+     * ----------------
+     * Adds elem if it isn't already present. As with cset_add, an element greater than the current greatest is
+     * appended without a search. Returns true if elem was added.
+     */
+    bool insert(const T& elem) {
+        size_type n = size_;
+        if(n > 0) {
+            const T& last = data()[n - 1];
+            if(cmp_(last, elem)) {
+                insert_at(elem, n);
+                return true;
+            }
+            if(!cmp_(elem, last)) return false;
+            n--;
+        }
+        size_type index = lower_bound_in(elem, 0, n);
+        if(index < n && !cmp_(elem, data()[index])) return false;
+        insert_at(elem, index);
+        return true;
+    }
+
+    /* Function: erase
+     * ---------------
+     * Removes elem if present and returns whether it was.
+     */
+    bool erase(const T& elem) {
+        size_type index = rank(elem);
+        if(index == size_ || cmp_(elem, data()[index])) return false;
+        erase_range(index, index + 1);
+        return true;
+    }
+
+    /* Function: erase_range
+     * ---------------------
+     * Removes the elements at indices i through j - 1, shifting whichever side of the range is shorter.
+     */
+    void erase_range(size_type i, size_type j) {
+        if(i > j || j > size_) throw std::out_of_range("csetpp::cset::erase_range");
+        T* first = buf_ + start_;
+        if(i < size_ - j) {
+            std::memmove(first + (j - i), first, i * sizeof(T));
+            start_ += j - i;
+        } else {
+            std::memmove(first + i, first + j, (size_ - j) * sizeof(T));
+        }
+        size_ -= j - i;
+    }
+
+    void pop_front() { erase_range(0, 1); }
+    void pop_back() { erase_range(size_ - 1, size_); }
+    void clear() noexcept { size_ = 0; }
+
+private:
+    T* buf_ = nullptr;
+    size_type start_ = 0;
+    size_type size_ = 0;
+    size_type cap_ = 0;
+    Compare cmp_;
+    Alloc alloc_;
+
+    size_type lower_bound_in(const T& elem, size_type low, size_type high) const {
+        if(low >= high) return low;
+        const T* base = data() + low;
+        size_type n = high - low;
+        while(n > 1) {
+            size_type half = n / 2;
+            base = cmp_(base[half], elem) ? base + half : base;
+            n -= half;
+        }
+        return (base - data()) + (cmp_(*base, elem) ? 1 : 0);
+    }
+
+    void relocate(size_type new_cap, size_type new_start) {
+        if(new_cap == cap_) {
+            std::memmove(buf_ + new_start, data(), size_ * sizeof(T));
+        } else {
+            T* new_buf = alloc_.allocate(new_cap);
+            if(size_ > 0) std::memcpy(new_buf + new_start, data(), size_ * sizeof(T));
+            if(buf_ != nullptr) alloc_.deallocate(buf_, cap_);
+            buf_ = new_buf;
+            cap_ = new_cap;
+        }
+        start_ = new_start;
+    }
+
+    //Same policy as CSet's make_room: recenter if a quarter of the buffer is free, otherwise grow.
+    void make_room(bool at_front) {
+        if(at_front ? start_ > 0 : start_ + size_ < cap_) return;
+        size_type new_cap = cap_;
+        if(cap_ == 0) new_cap = default_capacity;
+        else if((cap_ - size_) * 4 < cap_) new_cap = cap_ * 2;
+        size_type free_slots = new_cap - size_;
+        relocate(new_cap, at_front ? (free_slots + 1) / 2 : free_slots / 2);
+    }
+
+    void insert_at(const T& elem, size_type index) {
+        bool shift_front = index < size_ - index;
+        make_room(shift_front);
+        if(shift_front) {
+            std::memmove(buf_ + start_ - 1, buf_ + start_, index * sizeof(T));
+            start_--;
+        } else {
+            T* at = buf_ + start_ + index;
+            std::memmove(at + 1, at, (size_ - index) * sizeof(T));
+        }
+        std::memcpy(buf_ + start_ + index, &elem, sizeof(T));
+        size_++;
+    }
+};
+
+template <class T, class Compare, class Alloc>
+void swap(cset<T, Compare, Alloc>& a, cset<T, Compare, Alloc>& b) noexcept {
+    a.swap(b);
+}
+
+}
+
+#endif
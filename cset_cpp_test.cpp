@@ -0,0 +1,70 @@
+/* Filename: cset_cpp_test.cpp
+ * ---------------------------
+ * Tests for the C++ wrapper in cset.hpp, in the same print-and-expect style as set_test.c.
+ */
+
+#include "cset.hpp"
+
+#include <cstdio>
+#include <functional>
+#include <utility>
+
+using int_set = csetpp::cset<int>;
+
+static void print_set(const char* label, const int_set& set) {
+    printf("%s {", label);
+    for(int elem : set) printf(" %d", elem);
+    printf(" } (size %zu)\n", set.size());
+}
+
+static void basic_test() {
+    printf("----- basic_test -----\n");
+    int_set set = {5, 3, 9, 1, 7, 3};
+    print_set("initializer list", set); // expect { 1 3 5 7 9 }
+    bool first_insert = set.insert(4);
+    bool second_insert = set.insert(4);
+    printf("insert 4: %d, insert 4 again: %d\n", first_insert, second_insert); // expect 1, 0
+    printf("contains 7: %d, contains 8: %d\n", set.contains(7), set.contains(8)); // expect 1, 0
+    printf("rank of 6: %zu, at(2): %d\n", set.rank(6), set.at(2)); // expect 4, 4
+    set.erase(1);
+    set.pop_back();
+    print_set("after erase 1 and pop_back", set); // expect { 3 4 5 7 }
+
+    csetpp::cset<int, std::greater<int>> desc;
+    for(int i = 0; i < 100; i++) desc.insert(i % 10);
+    printf("descending: front %d, back %d, size %zu\n", desc.front(), desc.back(), desc.size()); // expect 9, 0, 10
+}
+
+static void copy_move_test() {
+    printf("----- copy_move_test -----\n");
+    int_set a;
+    for(int i = 1000; i > 0; i--) a.insert(i);
+    int_set b = a;
+    b.erase(500);
+    int_set c = std::move(a);
+    printf("copy size %zu, moved-to size %zu, moved-from size %zu\n", b.size(), c.size(), a.size());
+    // expect 999, 1000, 0
+    a = c;
+    printf("reassigned moved-from contains 500: %d\n", a.contains(500)); // expect 1
+}
+
+static void interop_test() {
+    printf("----- interop_test -----\n");
+    int_set set = {10, 20, 30};
+    const int* data = set.data();
+    CSet* c_set = set.release_to_c();
+    printf("shared buffer: %d, wrapper size now %zu\n", cset_first(c_set) == data, set.size()); // expect 1, 0
+    int forty = 40;
+    cset_add(c_set, &forty);
+    printf("C set size %d\n", cset_size(c_set)); // expect 4
+
+    int_set back = int_set::from_c(c_set);
+    print_set("back from C", back); // expect { 10 20 30 40 }
+}
+
+int main() {
+    basic_test();
+    copy_move_test();
+    interop_test();
+    return 0;
+}
@@ -0,0 +1,311 @@
+/* Filename: cset_typed.h
+ * ----------------------
+ * Type-specialized sets. The generic CSet calls the client's comparator through a function pointer on every probe
+ * and multiplies by elemsz on every access, which keeps the compiler from inlining or vectorizing anything. The macro
+ * CSET_DEFINE_TYPED generates a complete set implementation for one element type and one ordering, with every function
+ * static inline, so that comparisons compile down to single instructions.
+ *
+ * The generated sets have the same semantics as CSet: the elements are stored in a sorted array (with free space kept
+ * at both ends so either end can be popped in O(1) time), additions and removals use a binary search, and indices
+ * run from the least element to the greatest. Elements are stored and passed by value. Typed sets have no cleanup or
+ * toString functions, so they are meant for plain values such as numbers and pointers whose targets the set doesn't
+ * own.
+ *
+ * Pre-generated sets are provided for int (cset_int), int64_t (cset_int64), uint64_t (cset_uint64), double
+ * (cset_double), and void* (cset_ptr).
+ */
+
+#ifndef _cset_typed_h
+#define _cset_typed_h
+
+#include <stdbool.h>    //for bool
+#include <stdlib.h>     //for size_t, malloc
+#include <stdint.h>     //for int64_t, uint64_t
+#include <string.h>     //for memmove, memcpy
+#include <assert.h>
+
+//Default initial capacity and resizing factor, matching those of CSet.
+#define CSET_TYPED_DEFAULT_CAPACITY 32
+#define CSET_TYPED_RESIZE_FACTOR 2
+
+/* Macro: CSET_LESS
+ * ----------------
+ * The natural ordering of built-in types, usable as the less argument of CSET_DEFINE_TYPED.
+ */
+#define CSET_LESS(a, b) ((a) < (b))
+
+/* Macro: CSET_DEFINE_TYPED
+ * ------------------------
+ * Defines a set type called name holding elements of type T, ordered by less, which must be a function or function-like
+ * macro such that less(a, b) is true if a is strictly less than b. Two elements are equal if neither is less than the
+ * other. The following functions are generated, mirroring the CSet functions of the same name:
+ *
+ *      name* name_create(size_t capacity_hint)            void name_delete(name* set)
+ *      bool name_add(name* set, T elem)                    bool name_addHint(name* set, T elem, int hint_position)
+ *      void name_clear(name* set)                          bool name_contains(const name* set, T elem)
+ *      bool name_remove(name* set, T elem)                 void name_removeRange(name* set, int i, int j)
+ *      bool name_popFirst(name* set, T* out)               bool name_popLast(name* set, T* out)
+ *      int name_size(const name* set)                      bool name_isEmpty(const name* set)
+ *      T* name_at(const name* set, int i)                  int name_rank(const name* set, T elem)
+ *      T* name_first(const name* set)                      T* name_next(const name* set, T* prev)
+ *      bool name_isSubsetOf(const name* set1, const name* set2)
+ *      name* name_union(const name* set1, const name* set2)
+ *      name* name_intersect(const name* set1, const name* set2)
+ *      name* name_difference(const name* set1, const name* set2)
+ *
+ * name_addHint searches outward from hint_position, as cset_addHint does. The union, intersect, and difference
+ * functions use linear merges, since both inputs are sorted.
+ */
+#define CSET_DEFINE_TYPED(name, T, less)                                                                            \
+                                                                                                                    \
+typedef struct {                                                                                                    \
+    T* elements;                                                                                                    \
+    size_t start;                                                                                                   \
+    int n_elements;                                                                                                 \
+    size_t capacity;                                                                                                \
+} name;                                                                                                             \
+                                                                                                                    \
+static inline name* name##_create(size_t capacity_hint) {                                                           \
+    size_t capacity = capacity_hint == 0 ? CSET_TYPED_DEFAULT_CAPACITY : capacity_hint;                             \
+    name* set = malloc(sizeof(name));                                                                               \
+    assert(set != NULL);                                                                                            \
+    set->elements = malloc(capacity * sizeof(T));                                                                   \
+    assert(set->elements != NULL);                                                                                  \
+    set->start = 0;                                                                                                 \
+    set->n_elements = 0;                                                                                            \
+    set->capacity = capacity;                                                                                       \
+    return set;                                                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_delete(name* set) {                                                                       \
+    free(set->elements);                                                                                            \
+    free(set);                                                                                                      \
+}                                                                                                                   \
+                                                                                                                    \
+static inline T* name##_begin(const name* set) {                                                                    \
+    return set->elements + set->start;                                                                              \
+}                                                                                                                   \
+                                                                                                                    \
+/* Branchless lower bound: the loop body compiles to a conditional move, so random keys don't mispredict. */        \
+static inline int name##_lowerBoundIn(const name* set, T elem, int low, int high) {                                 \
+    if(low >= high) return low;                                                                                     \
+    T* base = name##_begin(set) + low;                                                                              \
+    int n = high - low;                                                                                             \
+    while(n > 1) {                                                                                                  \
+        int half = n / 2;                                                                                           \
+        base = less(base[half], elem) ? base + half : base;                                                         \
+        n -= half;                                                                                                  \
+    }                                                                                                               \
+    return (int)(base - name##_begin(set)) + (less(*base, elem) ? 1 : 0);                                           \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_relocate(name* set, size_t new_capacity, size_t new_start) {                              \
+    if(new_capacity == set->capacity) {                                                                             \
+        memmove(set->elements + new_start, name##_begin(set), set->n_elements * sizeof(T));                         \
+    } else {                                                                                                        \
+        T* new_elements = malloc(new_capacity * sizeof(T));                                                         \
+        assert(new_elements != NULL);                                                                               \
+        memcpy(new_elements + new_start, name##_begin(set), set->n_elements * sizeof(T));                           \
+        free(set->elements);                                                                                        \
+        set->elements = new_elements;                                                                               \
+        set->capacity = new_capacity;                                                                               \
+    }                                                                                                               \
+    set->start = new_start;                                                                                         \
+}                                                                                                                   \
+                                                                                                                    \
+/* Same policy as CSet: recenter if a quarter of the buffer is free, otherwise grow, favoring the needy side. */    \
+static inline void name##_makeRoom(name* set, bool at_front) {                                                      \
+    size_t back_free = set->capacity - set->start - set->n_elements;                                                \
+    if(at_front ? set->start > 0 : back_free > 0) return;                                                           \
+    size_t new_capacity = set->capacity;                                                                            \
+    if((set->capacity - set->n_elements) * 4 < set->capacity) new_capacity *= CSET_TYPED_RESIZE_FACTOR;             \
+    size_t free_slots = new_capacity - set->n_elements;                                                             \
+    name##_relocate(set, new_capacity, at_front ? (free_slots + 1) / 2 : free_slots / 2);                           \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_insert(name* set, T elem, int index) {                                                    \
+    bool shift_front = index < set->n_elements - index;                                                             \
+    name##_makeRoom(set, shift_front);                                                                              \
+    if(shift_front) {                                                                                               \
+        memmove(name##_begin(set) - 1, name##_begin(set), index * sizeof(T));                                       \
+        (set->start)--;                                                                                             \
+    } else {                                                                                                        \
+        T* at = name##_begin(set) + index;                                                                          \
+        memmove(at + 1, at, (set->n_elements - index) * sizeof(T));                                                 \
+    }                                                                                                               \
+    name##_begin(set)[index] = elem;                                                                                \
+    (set->n_elements)++;                                                                                            \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_add(name* set, T elem) {                                                                  \
+    int n = set->n_elements;                                                                                        \
+    if(n > 0) {                                                                                                     \
+        T last = name##_begin(set)[n - 1];                                                                          \
+        if(less(last, elem)) {                                                                                      \
+            name##_insert(set, elem, n);                                                                            \
+            return true;                                                                                            \
+        }                                                                                                           \
+        if(!less(elem, last)) return false;                                                                         \
+        n--;                                                                                                        \
+    }                                                                                                               \
+    int index = name##_lowerBoundIn(set, elem, 0, n);                                                               \
+    if(index < n && !less(elem, name##_begin(set)[index])) return false;                                            \
+    name##_insert(set, elem, index);                                                                                \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_addHint(name* set, T elem, int hint_position) {                                           \
+    int n = set->n_elements;                                                                                        \
+    int hint = hint_position < 0 ? 0 : (hint_position > n ? n : hint_position);                                     \
+    T* elements = name##_begin(set);                                                                                \
+    int index = hint;                                                                                               \
+    if(hint > 0 && !less(elements[hint - 1], elem)) {                                                               \
+        int high = hint - 1, step = 1, low = high - step;                                                           \
+        while(low >= 0 && !less(elements[low], elem)) {                                                             \
+            high = low;                                                                                             \
+            step *= 2;                                                                                              \
+            low = high - step;                                                                                      \
+        }                                                                                                           \
+        index = name##_lowerBoundIn(set, elem, low < 0 ? 0 : low + 1, high);                                        \
+    } else if(hint < n && less(elements[hint], elem)) {                                                             \
+        int low = hint + 1, step = 1, high = low + step;                                                            \
+        while(high <= n && less(elements[high - 1], elem)) {                                                        \
+            low = high;                                                                                             \
+            step *= 2;                                                                                              \
+            high = low + step;                                                                                      \
+        }                                                                                                           \
+        index = name##_lowerBoundIn(set, elem, low, high > n ? n : high - 1);                                       \
+    }                                                                                                               \
+    if(index < n && !less(elem, elements[index])) return false;                                                     \
+    name##_insert(set, elem, index);                                                                                \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_clear(name* set) {                                                                        \
+    set->n_elements = 0;                                                                                            \
+}                                                                                                                   \
+                                                                                                                    \
+static inline int name##_rank(const name* set, T elem) {                                                            \
+    return name##_lowerBoundIn(set, elem, 0, set->n_elements);                                                      \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_contains(const name* set, T elem) {                                                       \
+    int index = name##_rank(set, elem);                                                                             \
+    return index < set->n_elements && !less(elem, name##_begin(set)[index]);                                        \
+}                                                                                                                   \
+                                                                                                                    \
+static inline void name##_removeRange(name* set, int i, int j) {                                                    \
+    assert(0 <= i && i <= j && j <= set->n_elements);                                                               \
+    T* elements = name##_begin(set);                                                                                \
+    if(i < set->n_elements - j) {                                                                                   \
+        memmove(elements + (j - i), elements, i * sizeof(T));                                                       \
+        set->start += j - i;                                                                                        \
+    } else {                                                                                                        \
+        memmove(elements + i, elements + j, (set->n_elements - j) * sizeof(T));                                     \
+    }                                                                                                               \
+    set->n_elements -= j - i;                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_remove(name* set, T elem) {                                                               \
+    int index = name##_rank(set, elem);                                                                             \
+    if(index == set->n_elements || less(elem, name##_begin(set)[index])) return false;                              \
+    name##_removeRange(set, index, index + 1);                                                                      \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_popFirst(name* set, T* out) {                                                             \
+    if(set->n_elements == 0) return false;                                                                          \
+    if(out != NULL) *out = name##_begin(set)[0];                                                                    \
+    (set->start)++;                                                                                                 \
+    (set->n_elements)--;                                                                                            \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_popLast(name* set, T* out) {                                                              \
+    if(set->n_elements == 0) return false;                                                                          \
+    if(out != NULL) *out = name##_begin(set)[set->n_elements - 1];                                                  \
+    (set->n_elements)--;                                                                                            \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline int name##_size(const name* set) {                                                                    \
+    return set->n_elements;                                                                                         \
+}                                                                                                                   \
+                                                                                                                    \
+static inline bool name##_isEmpty(const name* set) {                                                                \
+    return set->n_elements == 0;                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+static inline T* name##_at(const name* set, int i) {                                                                \
+    if(i < 0 || i >= set->n_elements) return NULL;                                                                  \
+    return name##_begin(set) + i;                                                                                   \
+}                                                                                                                   \
+                                                                                                                    \
+static inline T* name##_first(const name* set) {                                                                    \
+    return name##_at(set, 0);                                                                                       \
+}                                                                                                                   \
+                                                                                                                    \
+static inline T* name##_next(const name* set, T* prev) {                                                            \
+    return name##_at(set, (int)(prev - name##_begin(set)) + 1);                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+/* Linear merge: advances through set2 in step with set1, since both are sorted. */                                 \
+static inline bool name##_isSubsetOf(const name* set1, const name* set2) {                                          \
+    T* a = name##_begin(set1);                                                                                      \
+    T* b = name##_begin(set2);                                                                                      \
+    int i = 0, j = 0;                                                                                               \
+    while(i < set1->n_elements) {                                                                                   \
+        while(j < set2->n_elements && less(b[j], a[i])) j++;                                                        \
+        if(j == set2->n_elements || less(a[i], b[j])) return false;                                                 \
+        i++;                                                                                                        \
+        j++;                                                                                                        \
+    }                                                                                                               \
+    return true;                                                                                                    \
+}                                                                                                                   \
+                                                                                                                    \
+/* Merges set1 and set2 into a new set, keeping elements found only in set1 (keep & 1), only in set2 (keep & 2), */ \
+/* or in both (keep & 4). Used to implement union, intersect, and difference. */                                    \
+static inline name* name##_merge(const name* set1, const name* set2, int keep) {                                    \
+    name* result = name##_create(set1->n_elements + set2->n_elements + 1);                                          \
+    T* a = name##_begin(set1);                                                                                      \
+    T* b = name##_begin(set2);                                                                                      \
+    T* out = result->elements;                                                                                      \
+    int i = 0, j = 0, n = 0;                                                                                        \
+    while(i < set1->n_elements || j < set2->n_elements) {                                                           \
+        if(j == set2->n_elements || (i < set1->n_elements && less(a[i], b[j]))) {                                   \
+            if(keep & 1) out[n++] = a[i];                                                                           \
+            i++;                                                                                                    \
+        } else if(i == set1->n_elements || less(b[j], a[i])) {                                                      \
+            if(keep & 2) out[n++] = b[j];                                                                           \
+            j++;                                                                                                    \
+        } else {                                                                                                    \
+            if(keep & 4) out[n++] = a[i];                                                                           \
+            i++;                                                                                                    \
+            j++;                                                                                                    \
+        }                                                                                                           \
+    }                                                                                                               \
+    result->n_elements = n;                                                                                         \
+    return result;                                                                                                  \
+}                                                                                                                   \
+                                                                                                                    \
+static inline name* name##_union(const name* set1, const name* set2) {                                              \
+    return name##_merge(set1, set2, 1 | 2 | 4);                                                                     \
+}                                                                                                                   \
+                                                                                                                    \
+static inline name* name##_intersect(const name* set1, const name* set2) {                                          \
+    return name##_merge(set1, set2, 4);                                                                             \
+}                                                                                                                   \
+                                                                                                                    \
+static inline name* name##_difference(const name* set1, const name* set2) {                                         \
+    return name##_merge(set1, set2, 1);                                                                             \
+}
+
+    /* * * * * Pre-Generated Typed Sets * * * * */
+
+CSET_DEFINE_TYPED(cset_int, int, CSET_LESS)
+CSET_DEFINE_TYPED(cset_int64, int64_t, CSET_LESS)
+CSET_DEFINE_TYPED(cset_uint64, uint64_t, CSET_LESS)
+CSET_DEFINE_TYPED(cset_double, double, CSET_LESS)
+CSET_DEFINE_TYPED(cset_ptr, void*, CSET_LESS)
+
+#endif
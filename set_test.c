@@ -4,6 +4,7 @@
  */
 
 #include "cset.h"
+#include "cset_typed.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -43,6 +44,115 @@ char* print_str(const void* addr) {
     return strdup(str);
 }
 
+/* Simple hash function for ints. */
+uint64_t hash_int(const void* addr) {
+    return *(int *)addr;
+}
+
+/* Simple predicate for ints: true if the int is divisible by the int at ctx. */
+bool is_multiple(const void* addr, void* ctx) {
+    int num = *(int *)addr;
+    int divisor = *(int *)ctx;
+    return num % divisor == 0;
+}
+
+/* Stateful predicate that accepts the first elements it sees, counting down the number left to accept in ctx. */
+bool take_first(const void* addr, void* ctx) {
+    int* remaining = ctx;
+    if(*remaining == 0) return false;
+    (*remaining)--;
+    return true;
+}
+
+/* Simple subset visitor: prints the subset and counts it in the int at ctx. Stops after 6 subsets. */
+bool print_and_count(CSet* subset, void* ctx) {
+    int* count = (int *)ctx;
+    char* subset_str = cset_toString(subset);
+    printf("%s ", subset_str);
+    free(subset_str);
+    (*count)++;
+    return *count < 6;
+}
+
+/* Subset visitor that sums subset sizes into the long at ctx. Stops once the sum exceeds 100. */
+bool sum_sizes(CSet* subset, void* ctx) {
+    long* sum = (long *)ctx;
+    *sum += cset_size(subset);
+    return *sum <= 100;
+}
+
+/* Simple key encoder for ints, for keyed sets. */
+void encode_int(const void* addr, void* key) {
+    cset_encodeInt64(key, *(int *)addr);
+}
+
+/* A record with a composite key: ordered by priority, then by score. */
+typedef struct {
+    int priority;
+    double score;
+    char name[8];
+} Task;
+
+/* Key encoder for tasks: the priority followed by the score, each in order-preserving form. */
+void encode_task(const void* addr, void* key) {
+    const Task* task = addr;
+    cset_encodeInt64(key, task->priority);
+    cset_encodeDouble((char *)key + 8, task->score);
+}
+
+/* A large record keyed by its id, for indirect sets. */
+typedef struct {
+    uint64_t id;
+    char payload[120];
+} Record;
+
+/* Key encoder for records: the id. */
+void encode_record(const void* addr, void* key) {
+    cset_encodeUint64(key, ((const Record *)addr)->id);
+}
+
+/* Comparator for records: by id. */
+int compare_records(const void* addr1, const void* addr2) {
+    uint64_t id1 = ((const Record *)addr1)->id, id2 = ((const Record *)addr2)->id;
+    return (id1 > id2) - (id1 < id2);
+}
+
+/* Predicate for records: true if the id is divisible by the int at ctx. */
+bool record_id_is_multiple(const void* addr, void* ctx) {
+    return ((const Record *)addr)->id % *(int *)ctx == 0;
+}
+
+/* A bump arena for sets: allocations are carved from one buffer in 16-byte steps, and frees are only counted. */
+typedef struct {
+    char* base;
+    size_t used;
+    size_t size;
+    int n_frees;
+} Arena;
+
+void* arena_alloc(void* ctx, size_t size) {
+    Arena* arena = ctx;
+    size_t offset = (arena->used + 15) / 16 * 16;
+    if(offset + size > arena->size) return NULL;
+    arena->used = offset + size;
+    return arena->base + offset;
+}
+
+void* arena_realloc(void* ctx, void* addr, size_t old_size, size_t new_size) {
+    void* resized = arena_alloc(ctx, new_size);
+    if(resized != NULL && old_size > 0) memcpy(resized, addr, old_size < new_size ? old_size : new_size);
+    return resized;
+}
+
+void arena_free(void* ctx, void* addr) {
+    ((Arena *)ctx)->n_frees++;
+}
+
+/* Returns true if addr points into the arena. */
+bool in_arena(Arena* arena, const void* addr) {
+    return (const char *)addr >= arena->base && (const char *)addr < arena->base + arena->used;
+}
+
 /* Helper function that prints the elements of a set. */
 void print_set(CSet* set) {
     char* set_string = cset_toString(set);
@@ -206,9 +316,1018 @@ void set_ops_test() {
     printf("Done!\n\n");
 }
 
+/* Test of positional access: cset_at, cset_rank, and cset_removeRange. */
+void positional_test() {
+    printf("\nCreating a set for positional access...\n");
+    CSet* set = cset_create(sizeof(int), 10, compare_ints, NULL, print_int);
+    int values[] = {40, 10, 70, 20, 90, 30, 60, 50, 80, 0};
+    for(int i = 0; i < 10; i++) {
+        cset_add(set, &values[i]);
+    }
+    print_set(set);
+
+    printf("\nElement at index 0 (expect 0): %d\n", *(int *)cset_at(set, 0));
+    printf("Element at index 9 (expect 90): %d\n", *(int *)cset_at(set, 9));
+    printf("Element at index 10 is NULL? (expect true): %s\n", cset_at(set, 10) == NULL ? "true" : "false");
+    printf("Median element (expect 50): %d\n", *(int *)cset_at(set, cset_size(set) / 2));
+
+    int probes[] = {50, 55, -5, 100};
+    printf("\nRanks of 50, 55, -5, 100 (expect 5 6 0 10):");
+    for(int i = 0; i < 4; i++) {
+        printf(" %d", cset_rank(set, &probes[i]));
+    }
+    printf("\n");
+    printf("Find 50 returns the stored element at index 5? (expect true): %s\n",
+           cset_find(set, &probes[0]) == cset_at(set, 5) ? "true" : "false");
+    printf("Find 55 returns NULL? (expect true): %s\n", cset_find(set, &probes[1]) == NULL ? "true" : "false");
+
+    printf("\nSearching a set too large for the L1 cache...\n");
+    CSet* large = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    for(int i = 0; i < 100000; i += 2) {
+        cset_add(large, &i);
+    }
+    int found = 0, rank_errors = 0;
+    for(int i = 0; i < 100000; i++) {
+        if(cset_contains(large, &i)) found++;
+        if(cset_rank(large, &i) != (i + 1) / 2) rank_errors++;
+    }
+    printf("Found %d elements (expect 50000) with %d rank errors (expect 0)\n", found, rank_errors);
+    cset_delete(large);
+
+    printf("\nRemoving indices 2 through 5...\n");
+    cset_removeRange(set, 2, 6);
+    print_set(set);
+    printf("Removing the first and last elements...\n");
+    cset_removeRange(set, 0, 1);
+    cset_removeRange(set, cset_size(set) - 1, cset_size(set));
+    print_set(set);
+
+    printf("\nDeleting set...\n");
+    cset_delete(set);
+    printf("Done!\n\n");
+}
+
+/* Test of splitting and concatenating ordered sets. */
+void split_concat_test() {
+    printf("\nCreating a set to split...\n");
+    CSet* set = cset_create(sizeof(int), 10, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 10; i++) {
+        cset_add(set, &i);
+    }
+    print_set(set);
+
+    CSet *left, *right;
+    int pivot = 4;
+    cset_split(set, &pivot, &left, &right);
+    printf("\nSplit around 4. Left (expect {1, 2, 3}): "); print_set(left);
+    printf("Right (expect {4, 5, 6, 7, 8, 9, 10}): "); print_set(right);
+    printf("Original set is empty? (expect true): %s\n", cset_isEmpty(set) ? "true" : "false");
+
+    printf("\nConcatenating right onto left succeeds? (expect true): %s\n", cset_concat(left, right) ? "true" : "false");
+    print_set(left);
+    printf("Right is empty? (expect true): %s\n", cset_isEmpty(right) ? "true" : "false");
+
+    int overlap = 5;
+    cset_add(right, &overlap);
+    printf("\nConcatenating {5} onto left succeeds? (expect false): %s\n", cset_concat(left, right) ? "true" : "false");
+    print_set(left);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(left);
+    cset_delete(right);
+    printf("Done!\n\n");
+}
+
+/* Test of predicate-based filtering. */
+void filter_test() {
+    printf("\nCreating a set to filter...\n");
+    CSet* set = cset_create(sizeof(int), 20, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 20; i++) {
+        cset_add(set, &i);
+    }
+    print_set(set);
+
+    int three = 3, two = 2;
+    CSet* multiples = cset_filter(set, is_multiple, &three);
+    printf("\nMultiples of 3 (expect {3, 6, 9, 12, 15, 18}): "); print_set(multiples);
+    int three_left = 3;
+    CSet* first_three = cset_filter(set, take_first, &three_left);
+    printf("First three, with a predicate that counts its calls (expect {1, 2, 3}): "); print_set(first_three);
+
+    int removed = cset_removeIf(set, is_multiple, &two);
+    printf("\nRemoved %d multiples of 2 (expect 10): ", removed); print_set(set);
+    removed = cset_removeIf(multiples, is_multiple, &two);
+    printf("Removed %d multiples of 2 from multiples of 3 (expect 3): ", removed); print_set(multiples);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(multiples);
+    cset_delete(first_three);
+    printf("Done!\n\n");
+}
+
+/* Test of using a set as a deduplicating priority queue with cset_popFirst and cset_popLast. */
+void pop_test() {
+    printf("\nCreating a set to use as a work queue...\n");
+    CSet* set = cset_create(sizeof(int), 4, compare_ints, NULL, print_int);
+    int values[] = {50, 20, 80, 20, 10, 90, 50, 30};
+    for(int i = 0; i < 8; i++) {
+        cset_add(set, &values[i]);
+    }
+    print_set(set);
+
+    int popped;
+    cset_popFirst(set, &popped);
+    printf("\nPopped first (expect 10): %d\n", popped);
+    cset_popLast(set, &popped);
+    printf("Popped last (expect 90): %d\n", popped);
+    print_set(set);
+
+    printf("\nInterleaving inserts at the front with pops...\n");
+    for(int i = 0; i < 40; i++) {
+        int work = i % 2 == 0 ? 15 - i : 100 + i;
+        cset_add(set, &work);
+        cset_popFirst(set, NULL);
+    }
+    print_set(set);
+
+    printf("\nDraining the set in order:");
+    while(cset_popFirst(set, &popped)) {
+        printf(" %d", popped);
+    }
+    printf("\nSet isEmpty? (expect true): %s\n", cset_isEmpty(set) ? "true" : "false");
+    printf("Pop from empty set succeeds? (expect false): %s\n", cset_popLast(set, NULL) ? "true" : "false");
+
+    printf("\nDeleting set...\n");
+    cset_delete(set);
+    printf("Done!\n\n");
+}
+
+/* Test of the append fast path and hinted insertion. */
+void hint_test() {
+    printf("\nAdding ascending elements (appended without searching)...\n");
+    CSet* sorted = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    for(int i = 0; i < 100; i++) {
+        cset_add(sorted, &i);
+    }
+    printf("Set has %d elements. (expect 100)\n", cset_size(sorted));
+
+    printf("\nAdding a nearly-sorted stream with hints...\n");
+    CSet* hinted = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    CSet* plain = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    int hint = 0;
+    for(int i = 0; i < 200; i++) {
+        //Mostly ascending, with every fifth value jumping back and every seventh a duplicate.
+        int value = i % 5 == 0 ? i - 13 : (i % 7 == 0 ? i - 1 : i);
+        if(cset_addHint(hinted, &value, hint)) hint = cset_rank(hinted, &value) + 1;
+        cset_add(plain, &value);
+    }
+    int out_of_range[] = {-50, 500, 77};
+    cset_addHint(hinted, &out_of_range[0], 1000);
+    cset_addHint(hinted, &out_of_range[1], -1000);
+    printf("Adding an existing element with a bad hint succeeds? (expect false): %s\n",
+           cset_addHint(hinted, &out_of_range[2], 0) ? "true" : "false");
+    cset_add(plain, &out_of_range[0]);
+    cset_add(plain, &out_of_range[1]);
+    printf("Hinted and plain sets are equal? (expect true): %s\n",
+           cset_compare(&hinted, &plain) == 0 ? "true" : "false");
+
+    printf("\nDeleting sets...\n");
+    cset_delete(sorted);
+    cset_delete(hinted);
+    cset_delete(plain);
+    printf("Done!\n\n");
+}
+
+/* Test of the streaming power set iterator. */
+void power_set_iterator_test() {
+    printf("\nIterating over the subsets of a set in Gray code order...\n");
+    CSet* set = cset_create(sizeof(int), 4, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 4; i++) {
+        cset_add(set, &i);
+    }
+    print_set(set);
+
+    CSet* power_set = cset_powerSet(set);
+    CSetSubsetIterator* it = cset_powerSetIterator(set);
+    int count = 0;
+    bool all_found = true;
+    for(CSet* subset = cset_subsetIteratorNext(it); subset != NULL; subset = cset_subsetIteratorNext(it)) {
+        print_set(subset);
+        if(!cset_contains(power_set, &subset)) all_found = false;
+        count++;
+    }
+    cset_subsetIteratorDelete(it);
+    printf("Iterated over %d subsets (expect 16)\n", count);
+    printf("Every subset is in the power set? (expect true): %s\n", all_found ? "true" : "false");
+
+    printf("\nIterating over the subsets of a 20-element set...\n");
+    CSet* large = cset_create(sizeof(int), 20, compare_ints, NULL, print_int);
+    for(int i = 0; i < 20; i++) {
+        cset_add(large, &i);
+    }
+    it = cset_powerSetIterator(large);
+    long total_size = 0;
+    for(CSet* subset = cset_subsetIteratorNext(it); subset != NULL; subset = cset_subsetIteratorNext(it)) {
+        total_size += cset_size(subset);
+    }
+    cset_subsetIteratorDelete(it);
+    printf("Sum of subset sizes is %ld (expect 10485760)\n", total_size);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(power_set);
+    cset_delete(large);
+    printf("Done!\n\n");
+}
+
+/* Test of bitmask-based subset families. */
+void family_test() {
+    printf("\nCreating the power set of a set as a subset family...\n");
+    CSet* set = cset_create(sizeof(int), 4, compare_ints, NULL, print_int);
+    int values[] = {10, 20, 30, 40};
+    for(int i = 0; i < 4; i++) {
+        cset_add(set, &values[i]);
+    }
+    print_set(set);
+
+    CSetFamily* power_set = cset_powerSetFamily(set);
+    printf("Family has %d subsets (expect 16)\n", cset_familySize(power_set));
+    printf("Subset 11 has %d elements (expect 3):", cset_subsetSize(power_set, 11));
+    for(void* elem = cset_subsetFirst(power_set, 11); elem != NULL; elem = cset_subsetNext(power_set, 11, elem)) {
+        printf(" %d", *(int *)elem);
+    }
+    printf("\nSubset 11 contains 30? (expect false): %s\n", cset_subsetContains(power_set, 11, &values[2]) ? "true" : "false");
+    printf("Subset 11 contains 40? (expect true): %s\n", cset_subsetContains(power_set, 11, &values[3]) ? "true" : "false");
+    CSet* subset = cset_subsetToSet(power_set, 11);
+    printf("Subset 11 as a set (expect {10, 20, 40}): "); print_set(subset);
+
+    printf("\nAdding sets to a family over a 100-element base...\n");
+    CSet* base = cset_create(sizeof(int), 100, compare_ints, NULL, print_int);
+    for(int i = 0; i < 100; i++) {
+        cset_add(base, &i);
+    }
+    CSetFamily* family = cset_familyCreate(base, 0);
+    int high[] = {5, 70, 99};
+    CSet* high_set = cset_create(sizeof(int), 3, compare_ints, NULL, print_int);
+    for(int i = 0; i < 3; i++) {
+        cset_add(high_set, &high[i]);
+    }
+    printf("Adding {5, 70, 99} succeeds? (expect true): %s\n", cset_familyAdd(family, high_set) ? "true" : "false");
+    int outside = 150;
+    cset_add(set, &outside);
+    printf("Adding {10, 20, 30, 40, 150} succeeds? (expect false): %s\n", cset_familyAdd(family, set) ? "true" : "false");
+    printf("Family has %d subsets (expect 1)\n", cset_familySize(family));
+    CSet* high_copy = cset_subsetToSet(family, 0);
+    printf("Subset 0 as a set (expect {5, 70, 99}): "); print_set(high_copy);
+
+    printf("\nDeleting families and sets...\n");
+    cset_familyDelete(power_set);
+    cset_familyDelete(family);
+    cset_delete(subset);
+    cset_delete(high_set);
+    cset_delete(high_copy);
+    cset_delete(base);
+    cset_delete(set);
+    printf("Done!\n\n");
+}
+
+/* Test of k-subset enumeration. */
+void combinations_test() {
+    printf("\nEnumerating k-element subsets of a set...\n");
+    CSet* set = cset_create(sizeof(int), 5, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 5; i++) {
+        cset_add(set, &i);
+    }
+    print_set(set);
+
+    int count = 0;
+    bool completed = cset_combinations(set, 2, print_and_count, &count);
+    printf("\nVisited %d of the 2-element subsets (expect 6), completed? (expect false): %s\n", count, completed ? "true" : "false");
+
+    count = 0;
+    completed = cset_combinations(set, 4, print_and_count, &count);
+    printf("\nVisited %d of the 4-element subsets (expect 5), completed? (expect true): %s\n", count, completed ? "true" : "false");
+
+    printf("\nCounting k-element subsets of a 20-element set with the iterator...\n");
+    CSet* large = cset_create(sizeof(int), 20, compare_ints, NULL, print_int);
+    for(int i = 0; i < 20; i++) {
+        cset_add(large, &i);
+    }
+    int counts[] = {0, 0, 0, 0};
+    int ks[] = {0, 1, 10, 20};
+    for(int i = 0; i < 4; i++) {
+        CSetSubsetIterator* it = cset_combinationsIterator(large, ks[i]);
+        for(CSet* subset = cset_subsetIteratorNext(it); subset != NULL; subset = cset_subsetIteratorNext(it)) {
+            if(cset_size(subset) == ks[i]) counts[i]++;
+        }
+        cset_subsetIteratorDelete(it);
+    }
+    printf("Counts for k = 0, 1, 10, 20 (expect 1 20 184756 1): %d %d %d %d\n", counts[0], counts[1], counts[2], counts[3]);
+    CSetSubsetIterator* it = cset_combinationsIterator(large, 21);
+    printf("A 21-element subset exists? (expect false): %s\n", cset_subsetIteratorNext(it) != NULL ? "true" : "false");
+    cset_subsetIteratorDelete(it);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(large);
+    printf("Done!\n\n");
+}
+
+/* Test of parallel power set generation. */
+void parallel_power_set_test() {
+    printf("\nGenerating power sets in parallel...\n");
+    CSet* set = cset_create(sizeof(int), 4, compare_ints, NULL, print_int);
+    int values[] = {7, 3, 9, 1};
+    for(int i = 0; i < 4; i++) {
+        cset_add(set, &values[i]);
+    }
+    CSet* parallel = cset_powerSetParallel(set, 3);
+    printf("Power set built with 3 threads: "); print_set(parallel);
+    CSet* serial = cset_powerSet(set);
+    printf("Matches cset_powerSet? (expect true): %s\n", cset_compare(&parallel, &serial) == 0 ? "true" : "false");
+
+    printf("\nMutating a subset that lives in a slab...\n");
+    CSet* subset = *(CSet **)cset_at(parallel, 5);
+    int extra = 100;
+    cset_add(subset, &extra);
+    print_set(subset);
+
+    CSet* large = cset_create(sizeof(int), 16, compare_ints, NULL, print_int);
+    for(int i = 0; i < 16; i++) {
+        cset_add(large, &i);
+    }
+    CSet* large_parallel = cset_powerSetParallel(large, 0);
+    CSet* large_serial = cset_powerSet(large);
+    printf("\nPower set of a 16-element set has %d subsets (expect 65536)\n", cset_size(large_parallel));
+    printf("Matches cset_powerSet? (expect true): %s\n", cset_compare(&large_parallel, &large_serial) == 0 ? "true" : "false");
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(parallel);
+    cset_delete(serial);
+    cset_delete(large);
+    cset_delete(large_parallel);
+    cset_delete(large_serial);
+    printf("Done!\n\n");
+}
+
+/* Test of resumable power set enumeration over large sets. */
+void power_set_cursor_test() {
+    printf("\nEnumerating a range of the subsets of a 40-element set...\n");
+    CSet* set = cset_create(sizeof(int), 40, compare_ints, NULL, print_int);
+    for(int i = 0; i < 40; i++) {
+        cset_add(set, &i);
+    }
+    printf("Cursor words for 40 elements (expect 1): %d\n", cset_powerSetCursorWords(set));
+
+    //Positions 2^39 - 2 through 2^39 + 1 straddle the point where element 39 enters the subset.
+    uint64_t first = ((uint64_t)1 << 39) - 2, last = first + 4;
+    CSetSubsetIterator* it = cset_powerSetIteratorRange(set, &first, &last);
+    for(CSet* subset = cset_subsetIteratorNext(it); subset != NULL; subset = cset_subsetIteratorNext(it)) {
+        print_set(subset);
+    }
+    cset_subsetIteratorDelete(it);
+
+    printf("\nCheckpointing an enumeration and resuming it...\n");
+    uint64_t cursor = 0;
+    long sum = 0;
+    bool completed = cset_powerSetForEach(set, &cursor, NULL, sum_sizes, &sum);
+    printf("Stopped early? (expect true): %s, at cursor %llu with sum %ld (expect 38 with sum 101)\n",
+           completed ? "false" : "true", (unsigned long long)cursor, sum);
+    uint64_t stop = 64;
+    completed = cset_powerSetForEach(set, &cursor, &stop, sum_sizes, &sum);
+    printf("Resumed run completed? (expect false), at cursor %llu (expect 39): %s\n",
+           (unsigned long long)cursor, completed ? "true" : "false");
+
+    printf("\nStarting at position 2^69 of the subsets of a 70-element set...\n");
+    CSet* large = cset_create(sizeof(int), 70, compare_ints, NULL, print_int);
+    for(int i = 0; i < 70; i++) {
+        cset_add(large, &i);
+    }
+    int words = cset_powerSetCursorWords(large);
+    uint64_t start[2] = {0, (uint64_t)1 << 5};
+    printf("Cursor words for 70 elements (expect 2): %d\n", words);
+    it = cset_powerSetIteratorRange(large, start, NULL);
+    for(int i = 0; i < 3; i++) {
+        print_set(cset_subsetIteratorNext(it));
+    }
+    uint64_t resume[2];
+    cset_subsetIteratorCursor(it, resume);
+    printf("Cursor after three subsets (expect 3 32): %llu %llu\n", (unsigned long long)resume[0], (unsigned long long)resume[1]);
+    cset_subsetIteratorDelete(it);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(large);
+    printf("Done!\n\n");
+}
+
+/* Test of modifying a power set whose subsets share one allocation. */
+void power_set_slab_test() {
+    printf("\nModifying a power set and its subsets...\n");
+    CSet* set = cset_create(sizeof(int), 3, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 3; i++) {
+        cset_add(set, &i);
+    }
+    CSet* power_set = cset_powerSet(set);
+    print_set(power_set);
+
+    CSet* subset = *(CSet **)cset_at(power_set, 7);
+    int extra = 4;
+    cset_add(subset, &extra);
+    printf("Largest subset after adding 4 (expect {1, 2, 3, 4}): "); print_set(subset);
+
+    CSet* empty = *(CSet **)cset_first(power_set);
+    cset_remove(power_set, &empty);
+    CSet* outside = cset_create(sizeof(int), 1, compare_ints, NULL, print_int);
+    cset_add(outside, &extra);
+    cset_add(power_set, &outside);
+    printf("After removing {} and adding {4}: "); print_set(power_set);
+
+    printf("\nSplitting a fresh power set of {1, 2, 3} around {2} and deleting it...\n");
+    CSet* fresh = cset_powerSet(set);
+    CSet* pivot = cset_create(sizeof(int), 1, compare_ints, NULL, print_int);
+    int two = 2;
+    cset_add(pivot, &two);
+    CSet *left, *right;
+    cset_split(fresh, &pivot, &left, &right);
+    cset_delete(fresh);
+    printf("Left (expect {{}, {1}}): "); print_set(left);
+    printf("Right (expect {{2}, {3}, {1, 2}, {1, 3}, {2, 3}, {1, 2, 3}}): "); print_set(right);
+
+    printf("\nConcatenating a power set of {1, 2} onto an empty set and deleting it...\n");
+    CSet* small = cset_create(sizeof(int), 2, compare_ints, NULL, print_int);
+    for(int i = 1; i <= 2; i++) {
+        cset_add(small, &i);
+    }
+    CSet* small_power_set = cset_powerSet(small);
+    CSet* receiver = cset_create(sizeof(CSet*), 0, cset_compare, cset_cleanup, cset_genericToString);
+    cset_concat(receiver, small_power_set);
+    cset_delete(small_power_set);
+    printf("Receiver (expect {{}, {1}, {2}, {1, 2}}): "); print_set(receiver);
+
+    printf("\nReleasing the buffer of a power set of {1, 2}...\n");
+    CSet* released = cset_powerSet(small);
+    size_t start, capacity;
+    int n_released;
+    CSet** buffer = cset_releaseBuffer(released, sizeof(CSet*), &start, &n_released, &capacity);
+    printf("Released subsets (expect {} {1} {2} {1, 2}): ");
+    for(int i = 0; i < n_released; i++) {
+        char* str = cset_toString(buffer[start + i]);
+        printf("%s ", str);
+        free(str);
+        cset_delete(buffer[start + i]);
+    }
+    printf("\n");
+    free(buffer);
+
+    printf("\nDeleting sets...\n");
+    cset_delete(set);
+    cset_delete(power_set);
+    cset_delete(pivot);
+    cset_delete(left);
+    cset_delete(right);
+    cset_delete(small);
+    cset_delete(receiver);
+    printf("Done!\n\n");
+}
+
+/* Test of the pre-generated type-specialized sets. */
+void typed_test() {
+    printf("\nCreating a typed set of ints...\n");
+    cset_int* ints = cset_int_create(0);
+    int values[] = {0, 2, 5, 9, 13, 1, 7, 42, 5, 9};
+    for(int i = 0; i < 10; i++) {
+        cset_int_add(ints, values[i]);
+    }
+    for(int* elem = cset_int_first(ints); elem != NULL; elem = cset_int_next(ints, elem)) {
+        printf("%d ", *elem);
+    }
+    printf("\nSet has %d elements. (expect 8)\n", cset_int_size(ints));
+    printf("Contains 13? (expect true): %s\n", cset_int_contains(ints, 13) ? "true" : "false");
+    printf("Rank of 10 (expect 6): %d\n", cset_int_rank(ints, 10));
+    cset_int_remove(ints, 13);
+    int popped;
+    cset_int_popFirst(ints, &popped);
+    printf("Popped %d (expect 0), size now %d (expect 6)\n", popped, cset_int_size(ints));
+
+    cset_int* odds = cset_int_create(0);
+    for(int i = 1; i < 10; i += 2) {
+        cset_int_addHint(odds, i, cset_int_size(odds));
+    }
+    cset_int* u = cset_int_union(ints, odds);
+    cset_int* intersect = cset_int_intersect(ints, odds);
+    cset_int* diff = cset_int_difference(ints, odds);
+    printf("Union, intersect, and difference sizes with {1, 3, 5, 7, 9} (expect 7 4 2): %d %d %d\n",
+           cset_int_size(u), cset_int_size(intersect), cset_int_size(diff));
+    printf("Intersect is a subset of the union? (expect true): %s\n", cset_int_isSubsetOf(intersect, u) ? "true" : "false");
+
+    printf("\nCreating a typed set of doubles...\n");
+    cset_double* doubles = cset_double_create(4);
+    double reals[] = {3.5, -1.25, 2.0, 3.5, 100.0};
+    for(int i = 0; i < 5; i++) {
+        cset_double_add(doubles, reals[i]);
+    }
+    for(int i = 0; i < cset_double_size(doubles); i++) {
+        printf("%g ", *cset_double_at(doubles, i));
+    }
+    printf("(expect -1.25 2 3.5 100)\n");
+
+    printf("\nDeleting typed sets...\n");
+    cset_int_delete(ints);
+    cset_int_delete(odds);
+    cset_int_delete(u);
+    cset_int_delete(intersect);
+    cset_int_delete(diff);
+    cset_double_delete(doubles);
+    printf("Done!\n\n");
+}
+
+/* Test using keyed sets, which are ordered by encoded keys instead of a comparator. */
+void keyed_test() {
+    printf("\nCreating a keyed set of ints...\n");
+    CSet* ints = cset_createKeyed(sizeof(int), 8, 4, encode_int, NULL, print_int);
+    int values[] = {5, -3, 9, 0, -100, 42, 5, 7};
+    for(int i = 0; i < 8; i++) {
+        cset_add(ints, &values[i]);
+    }
+    print_set(ints);
+    printf("Set has %d elements. (expect 7)\n", cset_size(ints));
+    int probes[] = {-100, 6, 42};
+    printf("Contains -100, 6, 42? (expect true false true): %s %s %s\n", cset_contains(ints, &probes[0]) ? "true" : "false",
+           cset_contains(ints, &probes[1]) ? "true" : "false", cset_contains(ints, &probes[2]) ? "true" : "false");
+    printf("Rank of 6 (expect 4): %d\n", cset_rank(ints, &probes[1]));
+    cset_remove(ints, &probes[0]);
+    print_set(ints);
+
+    CSet* others = cset_createKeyed(sizeof(int), 8, 0, encode_int, NULL, print_int);
+    for(int i = -4; i <= 4; i += 2) {
+        cset_add(others, &i);
+    }
+    CSet* u = cset_union(ints, others);
+    printf("Union with {-4, -2, 0, 2, 4} (expect {-4, -3, -2, 0, 2, 4, 5, 7, 9, 42}): ");
+    print_set(u);
+
+    int small_values[] = {3, 1, 2};
+    CSet* small = cset_createKeyed(sizeof(int), 8, 0, encode_int, NULL, print_int);
+    for(int i = 0; i < 3; i++) {
+        cset_add(small, &small_values[i]);
+    }
+    CSet* power_set = cset_powerSet(small);
+    printf("Power set of a keyed set (expect {{}, {1}, {2}, {3}, {1, 2}, {1, 3}, {2, 3}, {1, 2, 3}}): ");
+    print_set(power_set);
+    CSet* subset = *(CSet **)cset_at(power_set, 5);
+    printf("Subset {1, 3} is keyed and contains 3? (expect true): %s\n", cset_contains(subset, &small_values[0]) ? "true" : "false");
+
+    printf("\nCreating a keyed set of records with a composite key...\n");
+    CSet* tasks = cset_createKeyed(sizeof(Task), 16, 0, encode_task, NULL, NULL);
+    Task list[] = {{2, 0.5, "write"}, {1, 3.0, "plan"}, {2, -1.5, "review"}, {1, -7.25, "triage"}, {2, 0.5, "dup"}};
+    for(int i = 0; i < 5; i++) {
+        cset_add(tasks, &list[i]);
+    }
+    printf("Tasks in order (expect triage plan review write): ");
+    for(Task* task = cset_first(tasks); task != NULL; task = cset_next(tasks, task)) {
+        printf("%s ", task->name);
+    }
+    printf("\nDuplicate key was rejected? (expect true): %s\n", cset_size(tasks) == 4 ? "true" : "false");
+
+    printf("\nCreating a string set with shared prefixes...\n");
+    CSet* strs = cset_createStringSet(0, cleanup_str, print_str);
+    char* words[] = {"power set", "powerhouse", "powerhouses", "pow", "apple", "powerhouse", "", "power"};
+    for(int i = 0; i < 8; i++) {
+        char* word = strdup(words[i]);
+        if(!cset_add(strs, &word)) free(word);
+    }
+    printf("(expect {, apple, pow, power, power set, powerhouse, powerhouses}): ");
+    print_set(strs);
+    char* probe = "powerhouses";
+    char* missing = "powerhousf";
+    printf("Contains powerhouses, powerhousf? (expect true false): %s %s\n", cset_contains(strs, &probe) ? "true" : "false",
+           cset_contains(strs, &missing) ? "true" : "false");
+    printf("Rank of powerhousf (expect 7): %d\n", cset_rank(strs, &missing));
+
+    printf("\nDeleting keyed sets...\n");
+    cset_delete(ints);
+    cset_delete(others);
+    cset_delete(u);
+    cset_delete(small);
+    cset_delete(power_set);
+    cset_delete(tasks);
+    cset_delete(strs);
+    printf("Done!\n\n");
+}
+
+/* Test of indirect keyed sets of large records. */
+void indirect_test() {
+    printf("\nCreating an indirect set of 128-byte records...\n");
+    CSet* records = cset_createKeyedIndirect(sizeof(Record), 8, 0, encode_record, NULL, NULL);
+    Record record;
+    memset(&record, 0, sizeof(record));
+    //Visits the ids 0 through 999 in a scrambled order (7 and 1000 are coprime).
+    for(int i = 0; i < 1000; i++) {
+        record.id = (uint64_t)i * 7 % 1000;
+        snprintf(record.payload, sizeof(record.payload), "record %d", (int)record.id);
+        cset_add(records, &record);
+    }
+    printf("Set has %d records. (expect 1000)\n", cset_size(records));
+    record.id = 500;
+    Record* found = cset_find(records, &record);
+    printf("Found record 500 (expect record 500): %s\n", found->payload);
+
+    int three = 3;
+    printf("Removed %d multiples of 3 (expect 334)\n", cset_removeIf(records, record_id_is_multiple, &three));
+    for(int i = 1000; i < 2000; i++) {
+        record.id = i;
+        snprintf(record.payload, sizeof(record.payload), "record %d", i);
+        cset_add(records, &record);
+    }
+    printf("Record 500 didn't move? (expect true): %s\n", cset_find(records, found) == found && found->id == 500 ? "true" : "false");
+    printf("Rank of record 500 (expect 333): %d\n", cset_rank(records, found));
+    long sum = 0;
+    for(Record* r = cset_first(records); r != NULL; r = cset_next(records, r)) sum += r->id;
+    printf("Sum of ids (expect 1832167): %ld\n", sum);
+
+    CSet *left, *right;
+    cset_split(records, found, &left, &right);
+    printf("\nSplit around 500. Sizes (expect 333 1333): %d %d\n", cset_size(left), cset_size(right));
+    printf("Least of right is record 500 (expect record 500): %s\n", ((Record *)cset_first(right))->payload);
+    Record last;
+    cset_popLast(left, &last);
+    printf("Popped the greatest of left (expect record 499): %s\n", last.payload);
+    printf("Concatenating right onto left succeeds? (expect true): %s\n", cset_concat(left, right) ? "true" : "false");
+    printf("Sizes (expect 1665 0): %d %d\n", cset_size(left), cset_size(right));
+    cset_add(right, &last);
+    CSet* u = cset_union(left, right);
+    printf("Union with {499} has %d records (expect 1666); record 499 reads (expect record 499): %s\n", cset_size(u),
+           ((Record *)cset_find(u, &last))->payload);
+
+    printf("\nCreating an indirect set ordered by a comparator...\n");
+    CSet* by_id = cset_createIndirect(sizeof(Record), 0, compare_records, NULL, NULL);
+    Record* refs[10];
+    for(int i = 0; i < 10; i++) {
+        record.id = 1000 + i * 10;
+        snprintf(record.payload, sizeof(record.payload), "record %d", (int)record.id);
+        cset_add(by_id, &record);
+        refs[i] = cset_find(by_id, &record);
+    }
+    //Inserting in front of every element and growing the array many times over moves no records.
+    for(int i = 999; i >= 0; i--) {
+        record.id = i;
+        cset_add(by_id, &record);
+    }
+    cset_remove(by_id, refs[4]);
+    bool stable = true;
+    for(int i = 0; i < 10; i++) {
+        if(i != 4) stable = stable && refs[i]->id == 1000 + i * 10 && cset_find(by_id, refs[i]) == refs[i];
+    }
+    printf("References are stable? (expect true): %s\n", stable ? "true" : "false");
+    printf("Size and rank of record 1090 (expect 1009 1008): %d %d\n", cset_size(by_id), cset_rank(by_id, refs[9]));
+    printf("Successor of record 1030 (expect record 1050): %s\n", ((Record *)cset_next(by_id, refs[3]))->payload);
+
+    printf("\nDeleting indirect sets...\n");
+    cset_delete(by_id);
+    cset_delete(records);
+    cset_delete(left);
+    cset_delete(right);
+    cset_delete(u);
+    printf("Done!\n\n");
+}
+
+/* Test of sets backed by a client-supplied allocator. */
+void allocator_test() {
+    printf("\nCreating sets in an arena...\n");
+    Arena arena = {malloc(1 << 20), 0, 1 << 20, 0};
+    CSetAllocator allocator = {arena_alloc, arena_realloc, arena_free, &arena};
+    CSet* a = cset_createWithAllocator(sizeof(int), 4, compare_ints, NULL, print_int, &allocator);
+    CSet* b = cset_createWithAllocator(sizeof(int), 4, compare_ints, NULL, print_int, &allocator);
+    for(int i = 1; i <= 20; i++) {
+        cset_add(a, &i);
+        int j = i + 10;
+        cset_add(b, &j);
+    }
+    CSet* u = cset_union(a, b);
+    CSet* intersect = cset_intersect(a, b);
+    printf("Union has %d elements, intersect has %d. (expect 30 10)\n", cset_size(u), cset_size(intersect));
+    int five = 5;
+    CSet* small = cset_filter(a, is_multiple, &five);
+    CSet* power_set = cset_powerSet(small);
+    CSet* parallel = cset_powerSetParallel(small, 3);
+    printf("Serial and parallel power sets of {5, 10, 15, 20} (expect 16 16 equal): %d %d %s\n", cset_size(power_set),
+           cset_size(parallel), cset_equals(power_set, parallel) ? "equal" : "different");
+    CSet* subset = *(CSet **)cset_at(power_set, 15);
+    printf("Derived sets, their elements, and subsets live in the arena? (expect true): %s\n",
+           in_arena(&arena, u) && in_arena(&arena, cset_first(u)) && in_arena(&arena, intersect) &&
+           in_arena(&arena, power_set) && in_arena(&arena, subset) && in_arena(&arena, cset_first(subset)) &&
+           in_arena(&arena, *(CSet **)cset_at(parallel, 15)) ? "true" : "false");
+
+    printf("\nDeleting one set frees through the arena? (expect true): ");
+    cset_delete(a);
+    printf("%s\n", arena.n_frees > 0 ? "true" : "false");
+    printf("Releasing the arena, and every other set with it...\n");
+    free(arena.base);
+    printf("Done!\n\n");
+}
+
+/* Test of capacity management and growth policies. */
+void capacity_test() {
+    printf("\nReserving room for 1000 elements...\n");
+    CSet* set = cset_create(sizeof(int), 4, compare_ints, NULL, print_int);
+    cset_reserve(set, 1000);
+    size_t reserved = cset_capacity(set);
+    for(int i = 0; i < 1000; i++) {
+        int value = (i * 37) % 1000;
+        cset_add(set, &value);
+    }
+    printf("Capacity is at least 1000 and unchanged by adding 1000 elements? (expect true): %s\n",
+           reserved >= 1000 && cset_capacity(set) == reserved ? "true" : "false");
+    cset_removeRange(set, 10, 1000);
+    cset_shrinkToFit(set);
+    printf("After removing 990 and shrinking to fit, capacity (expect 10): %zu\n", cset_capacity(set));
+    print_set(set);
+
+    printf("\nGrowing by at most 100 slots at a time, shrinking below a quarter full...\n");
+    CSetGrowthPolicy policy = {2, 100, 0.25};
+    cset_setGrowthPolicy(set, &policy);
+    size_t max_capacity = 0;
+    for(int i = 10; i < 1000; i++) {
+        cset_add(set, &i);
+        if(cset_capacity(set) > max_capacity) max_capacity = cset_capacity(set);
+    }
+    printf("Peak capacity for 1000 elements is at most 1150? (expect true): %s\n", max_capacity <= 1150 ? "true" : "false");
+    CSet *left, *right;
+    int pivot = 500;
+    cset_split(set, &pivot, &left, &right);
+    int two = 2;
+    int removed = cset_removeIf(right, is_multiple, &two);
+    printf("Removed evens from the right half; removed and capacity (expect 250 500): %d %zu\n", removed,
+           cset_capacity(right));
+    while(cset_size(right) > 10) cset_popFirst(right, NULL);
+    printf("After popping down to 10 elements, capacity is below 40? (expect true): %s\n",
+           cset_capacity(right) < 40 ? "true" : "false");
+    cset_clear(right);
+    printf("After clearing, capacity (expect 1): %zu\n", cset_capacity(right));
+
+    cset_delete(set);
+    cset_delete(left);
+    cset_delete(right);
+    printf("Done!\n\n");
+}
+
+/* Returns the total memory of a set, including its nested sets. */
+size_t total_memory(CSet* set) {
+    CSetMemoryUsage usage = cset_memoryUsage(set, true);
+    return usage.header_bytes + usage.allocated_bytes + usage.children_bytes;
+}
+
+/* Test of memory accounting. */
+void memory_test() {
+    printf("\nMeasuring a set of 5 ints with room for 10...\n");
+    CSet* ints = cset_create(sizeof(int), 10, compare_ints, NULL, print_int);
+    for(int i = 0; i < 5; i++) {
+        cset_add(ints, &i);
+    }
+    CSetMemoryUsage usage = cset_memoryUsage(ints, true);
+    printf("Allocated, used and children bytes (expect 40 20 0): %zu %zu %zu\n", usage.allocated_bytes,
+           usage.used_bytes, usage.children_bytes);
+    CSet* clone = cset_clone(ints);
+    size_t shared_total = cset_memoryUsage(ints, true).allocated_bytes + cset_memoryUsage(clone, true).allocated_bytes;
+    printf("A set and its clone count their shared array and its reference count once? (expect true): %s\n",
+           shared_total == 10 * sizeof(int) + sizeof(int) ? "true" : "false");
+    cset_delete(clone);
+
+    printf("\nMeasuring a set of sets...\n");
+    CSet* outer = cset_create(sizeof(CSet*), 0, cset_compare, cset_cleanup, cset_genericToString);
+    CSet* inner = cset_create(sizeof(int), 8, compare_ints, NULL, print_int);
+    cset_add(outer, &ints);
+    cset_add(outer, &inner);
+    printf("Children bytes are the totals of the two inner sets? (expect true): %s\n",
+           cset_memoryUsage(outer, true).children_bytes == total_memory(ints) + total_memory(inner) ? "true" : "false");
+    printf("Children bytes when not recursive (expect 0): %zu\n", cset_memoryUsage(outer, false).children_bytes);
+
+    printf("\nMeasuring the power set of {0, 1, 2, 3, 4}...\n");
+    CSet* power_set = cset_powerSet(ints);
+    usage = cset_memoryUsage(power_set, true);
+    printf("Subsets live in the power set's slab, so children bytes are (expect 0): %zu\n", usage.children_bytes);
+    size_t header_bytes = cset_memoryUsage(inner, false).header_bytes;
+    size_t expected = 32 * sizeof(CSet*) + sizeof(void*) + 32 * header_bytes + 81 * sizeof(int);
+    printf("Allocated bytes are 32 pointers, the slab list, and a slab of 32 headers and 81 ints? (expect true): %s\n",
+           usage.allocated_bytes == expected ? "true" : "false");
+    CSet* subset = *(CSet **)cset_at(power_set, 1);
+    int five = 5;
+    cset_add(subset, &five);
+    printf("After growing subset {0}, its new array counts as children bytes (expect true): %s\n",
+           cset_memoryUsage(power_set, true).children_bytes == cset_capacity(subset) * sizeof(int) ? "true" : "false");
+
+    cset_delete(outer);
+    cset_delete(power_set);
+    printf("Done!\n\n");
+}
+
+/* Test of copy-on-write clones. */
+void clone_test() {
+    printf("\nCloning {0, ..., 9}...\n");
+    CSet* original = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    for(int i = 0; i < 10; i++) {
+        cset_add(original, &i);
+    }
+    CSet* clone = cset_clone(original);
+    printf("Clone equals the original? (expect true): %s\n", cset_equals(clone, original) ? "true" : "false");
+
+    int ten = 10;
+    cset_add(original, &ten);
+    printf("After adding 10 to the original, the clone contains 10? (expect false): %s\n",
+           cset_contains(clone, &ten) ? "true" : "false");
+    printf("Sizes of the original and the clone (expect 11 10): %d %d\n", cset_size(original), cset_size(clone));
+
+    CSet* second = cset_clone(clone);
+    CSet* third = cset_clone(second);
+    cset_popFirst(clone, NULL);
+    cset_popLast(clone, NULL);
+    printf("After popping both ends of the clone, its clones' sizes are (expect 10 10): %d %d\n", cset_size(second),
+           cset_size(third));
+    int zero = 0;
+    cset_remove(second, &zero);
+    printf("After removing 0 from a second clone, the third still has it? (expect true): %s\n",
+           cset_contains(third, &zero) ? "true" : "false");
+    cset_delete(original);
+    cset_delete(third);
+    printf("The remaining clones, after deleting the original and the third (expect {1, ..., 8} {1, ..., 9}):\n");
+    print_set(clone);
+    print_set(second);
+    cset_delete(clone);
+    cset_delete(second);
+
+    printf("\nCloning an indirect set of records...\n");
+    CSet* records = cset_createIndirect(sizeof(Record), 0, compare_records, NULL, NULL);
+    for(int i = 0; i < 20; i++) {
+        Record record = {i, ""};
+        cset_add(records, &record);
+    }
+    CSet* records_clone = cset_clone(records);
+    cset_delete(records);
+    printf("Clone outlives the original and still has all 20 records? (expect 20): %d\n", cset_size(records_clone));
+    cset_delete(records_clone);
+
+    printf("\nCloning a subset in a power set's slab...\n");
+    CSet* base = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    for(int i = 0; i < 3; i++) {
+        cset_add(base, &i);
+    }
+    CSet* power_set = cset_powerSet(base);
+    CSet* subset = *(CSet **)cset_at(power_set, cset_size(power_set) - 1);
+    CSet* subset_clone = cset_clone(subset);
+    cset_delete(power_set);
+    printf("Clone of {0, 1, 2} after deleting the power set (expect {0, 1, 2}):\n");
+    print_set(subset_clone);
+    cset_delete(subset_clone);
+    cset_delete(base);
+    printf("Done!\n\n");
+}
+
+/* Test of set hashing and equality. */
+void hash_test() {
+    printf("\nBuilding equal sets in different orders...\n");
+    CSet* ascending = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    CSet* descending = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    cset_setHashFn(ascending, hash_int);
+    cset_setHashFn(descending, hash_int);
+    for(int i = 0; i < 50; i++) {
+        int up = i, down = 49 - i;
+        cset_add(ascending, &up);
+        cset_add(descending, &down);
+    }
+    printf("Hashes are equal? (expect true): %s\n", cset_hash(ascending) == cset_hash(descending) ? "true" : "false");
+    printf("Sets are equal? (expect true): %s\n", cset_equals(ascending, descending) ? "true" : "false");
+
+    int extra = 100;
+    cset_add(ascending, &extra);
+    cset_popFirst(ascending, NULL);
+    printf("Equal after adding 100 and popping 0? (expect false): %s\n", cset_equals(ascending, descending) ? "true" : "false");
+    int zero = 0;
+    cset_remove(ascending, &extra);
+    cset_add(ascending, &zero);
+    printf("Hashes equal again after undoing that? (expect true): %s\n",
+           cset_hash(ascending) == cset_hash(descending) ? "true" : "false");
+
+    CSet *left, *right;
+    int pivot = 20;
+    cset_split(ascending, &pivot, &left, &right);
+    cset_concat(left, right);
+    printf("Hash survives a split and concat? (expect true): %s\n", cset_hash(left) == cset_hash(descending) ? "true" : "false");
+
+    printf("\nHashing sets of sets...\n");
+    int values[] = {4, 8, 15, 16};
+    CSet* small = cset_create(sizeof(int), 0, compare_ints, NULL, print_int);
+    cset_setHashFn(small, hash_int);
+    for(int i = 0; i < 4; i++) {
+        cset_add(small, &values[i]);
+    }
+    CSet* power_set = cset_powerSet(small);
+    CSet* parallel = cset_powerSetParallel(small, 2);
+    printf("Power sets hash equally? (expect true): %s\n", cset_hash(power_set) == cset_hash(parallel) ? "true" : "false");
+    printf("Power sets are equal? (expect true): %s\n", cset_equals(power_set, parallel) ? "true" : "false");
+    CSet* subset = *(CSet **)cset_at(power_set, 15);
+    cset_remove(subset, &values[0]);
+    printf("Equal after changing a subset? (expect false): %s\n", cset_equals(power_set, parallel) ? "true" : "false");
+
+    CSet* keyed = cset_createKeyed(sizeof(int), 8, 0, encode_int, NULL, print_int);
+    CSet* keyed_copy = cset_createKeyed(sizeof(int), 8, 0, encode_int, NULL, print_int);
+    for(int i = 0; i < 4; i++) {
+        cset_add(keyed, &values[i]);
+        cset_add(keyed_copy, &values[3 - i]);
+    }
+    printf("Keyed sets hash by key, equal? (expect true): %s\n", cset_hash(keyed) == cset_hash(keyed_copy) ? "true" : "false");
+
+    printf("\nDeleting sets...\n");
+    cset_delete(ascending);
+    cset_delete(descending);
+    cset_delete(left);
+    cset_delete(right);
+    cset_delete(small);
+    cset_delete(power_set);
+    cset_delete(parallel);
+    cset_delete(keyed);
+    cset_delete(keyed_copy);
+    printf("Done!\n\n");
+}
+
+/* Helper for intern_test: returns a new hashable set of the given ints, added in the given order. */
+CSet* int_set_of(int* values, int n) {
+    CSet* set = cset_create(sizeof(int), n, compare_ints, NULL, print_int);
+    cset_setHashFn(set, hash_int);
+    for(int i = 0; i < n; i++) {
+        cset_add(set, &values[i]);
+    }
+    return set;
+}
+
+/* Test of interning sets and sets of sets. */
+void intern_test() {
+    printf("\nInterning equal sets...\n");
+    CSetInternTable* table = cset_internTableCreate(0);
+    int forward[] = {1, 2, 3}, backward[] = {3, 2, 1}, other[] = {1, 2, 4};
+    CSet* a = cset_intern(table, int_set_of(forward, 3));
+    CSet* b = cset_intern(table, int_set_of(backward, 3));
+    CSet* c = cset_intern(table, int_set_of(other, 3));
+    printf("{1, 2, 3} interned twice is the same set? (expect true): %s\n", a == b ? "true" : "false");
+    printf("{1, 2, 4} is a different set? (expect true): %s\n", a != c ? "true" : "false");
+    printf("Interned sets equal? (expect true false): %s %s\n", cset_equals(a, b) ? "true" : "false",
+           cset_equals(a, c) ? "true" : "false");
+
+    printf("\nInterning sets of interned sets...\n");
+    CSet* outer1 = cset_create(sizeof(CSet*), 2, cset_compare, cset_cleanup, cset_genericToString);
+    CSet* outer2 = cset_create(sizeof(CSet*), 2, cset_compare, cset_cleanup, cset_genericToString);
+    cset_setHashFn(outer1, cset_genericHash);
+    cset_setHashFn(outer2, cset_genericHash);
+    CSet* inner = cset_retain(a);
+    cset_add(outer1, &inner);
+    cset_add(outer1, &c);
+    cset_add(outer2, &b);
+    inner = cset_intern(table, int_set_of(other, 3));
+    cset_add(outer2, &inner);
+    outer1 = cset_intern(table, outer1);
+    outer2 = cset_intern(table, outer2);
+    printf("Outer sets are the same set? (expect true): %s\n", outer1 == outer2 ? "true" : "false");
+    print_set(outer1);
+
+    printf("\nReleasing references...\n");
+    cset_delete(outer1);
+    printf("Inner sets survive while the outer set is referenced: ");
+    print_set(outer2);
+    cset_delete(outer2);
+    printf("After releasing the outer set, {1, 2, 3} is still interned? (expect true): %s\n",
+           cset_intern(table, int_set_of(forward, 3)) == a ? "true" : "false");
+    cset_delete(a);
+    cset_delete(a);
+    cset_internTableDelete(table);
+    printf("Done!\n\n");
+}
+
 int main(int argc, char* argv[]) {
     simple_test();
     nested_sets_test();
     set_ops_test();
+    positional_test();
+    split_concat_test();
+    filter_test();
+    pop_test();
+    hint_test();
+    power_set_iterator_test();
+    family_test();
+    combinations_test();
+    parallel_power_set_test();
+    power_set_cursor_test();
+    power_set_slab_test();
+    typed_test();
+    keyed_test();
+    indirect_test();
+    allocator_test();
+    capacity_test();
+    memory_test();
+    clone_test();
+    hash_test();
+    intern_test();
     return 0;
 }